@@ -0,0 +1,297 @@
+#ifndef AISDI_MAPS_AGGREGATETREEMAP_H
+#define AISDI_MAPS_AGGREGATETREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "TreeBalance.h"
+#include "TreeMap.h"
+
+namespace aisdi
+{
+
+// Monoids for AggregateTreeMap: identity() and an associative operator().
+template <typename T>
+struct SumAggregate
+{
+  T identity() const
+  {
+    return T();
+  }
+
+  T operator()(const T& a, const T& b) const
+  {
+    return a + b;
+  }
+};
+
+template <typename T>
+struct MinAggregate
+{
+  T identity() const
+  {
+    return std::numeric_limits<T>::max();
+  }
+
+  T operator()(const T& a, const T& b) const
+  {
+    return std::min(a, b);
+  }
+};
+
+template <typename T>
+struct MaxAggregate
+{
+  T identity() const
+  {
+    return std::numeric_limits<T>::lowest();
+  }
+
+  T operator()(const T& a, const T& b) const
+  {
+    return std::max(a, b);
+  }
+};
+
+// AVL balance whose nodes also cache the monoid fold of their subtree, kept up to date by update().
+// AVL rebalancing stops where heights settle, so inserts, removals and assignments refresh the folds
+// on the rest of the path themselves. The monoid is default constructed for every fold.
+template <typename Monoid>
+struct AggregateBalance : AvlBalanceOf<AggregateBalance<Monoid>>
+{
+    using Base = AvlBalanceOf<AggregateBalance>;
+    using aggregate_type = typename std::decay<decltype(std::declval<const Monoid&>().identity())>::type;
+
+    struct Augment
+    {
+        aggregate_type aggregate = Monoid().identity();
+    };
+
+    template <typename Node>
+    static void update(Node* node) {
+        Base::update(node);
+        node->aggregate = Monoid()(Monoid()(aggregateOf(node->left), lift(node)), aggregateOf(node->right));
+    }
+
+    template <typename Node>
+    static Node* inserted(Node* node) {
+        Node* top = Base::inserted(node);
+        refresh(node);
+        return top;
+    }
+
+    template <typename Node>
+    static Node* erased(Node* parent, Node* child, bool fromLeft, int state) {
+        Node* top = Base::erased(parent, child, fromLeft, state);
+        refresh(parent);
+        return top;
+    }
+
+    template <typename Node>
+    static void assigned(Node* node) {
+        refresh(node);
+    }
+
+    template <typename Node>
+    static aggregate_type aggregateOf(const Node* node) {
+        return node == nullptr ? Monoid().identity() : node->aggregate;
+    }
+
+    // fold of values with keys in [lo, hi) under root
+    template <typename Node, typename Key, typename Compare>
+    static aggregate_type aggregate(const Node* root, const Key& lo, const Key& hi, const Compare& compare) {
+        const Monoid monoid{};
+        if(!compare(lo, hi)) return monoid.identity();
+
+        const Node *node = root;
+        while(node != nullptr) {
+            if(compare(node->value.first, lo))
+                node = node->right;
+            else if(!compare(node->value.first, hi))
+                node = node->left;
+            else break;
+        }
+
+        if(node == nullptr) return monoid.identity();
+
+        aggregate_type middle = monoid(atLeast(node->left, lo, compare), lift(node));
+        return monoid(middle, lessThan(node->right, hi, compare));
+    }
+
+private:
+    template <typename Node>
+    static aggregate_type lift(const Node* node) {
+        return aggregate_type(node->value.second);
+    }
+
+    // updates node and its ancestors up to the guard
+    template <typename Node>
+    static void refresh(Node* node) {
+        for(; node->parent != nullptr; node = node->parent)
+            update(node);
+    }
+
+    // fold of keys not less than lo, collected right to left
+    template <typename Node, typename Key, typename Compare>
+    static aggregate_type atLeast(const Node* node, const Key& lo, const Compare& compare) {
+        const Monoid monoid{};
+        aggregate_type result = monoid.identity();
+
+        while(node != nullptr) {
+            if(compare(node->value.first, lo)) {
+                node = node->right;
+            } else {
+                result = monoid(monoid(lift(node), aggregateOf(node->right)), result);
+                node = node->left;
+            }
+        }
+
+        return result;
+    }
+
+    // fold of keys less than hi, collected left to right
+    template <typename Node, typename Key, typename Compare>
+    static aggregate_type lessThan(const Node* node, const Key& hi, const Compare& compare) {
+        const Monoid monoid{};
+        aggregate_type result = monoid.identity();
+
+        while(node != nullptr) {
+            if(compare(node->value.first, hi)) {
+                result = monoid(result, monoid(aggregateOf(node->left), lift(node)));
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+
+        return result;
+    }
+};
+
+// TreeMap balanced by AggregateBalance, so aggregate(lo, hi) is O(log n).
+// Values are combined in key order, the monoid does not have to be commutative, but it has to be
+// stateless. Values can only be changed through insert(), which keeps the cached folds up to date.
+template <typename KeyType, typename ValueType, typename Monoid = SumAggregate<ValueType>,
+          typename Compare = std::less<KeyType>>
+class AggregateTreeMap
+{
+  using Balance = AggregateBalance<Monoid>;
+  using Items = TreeMap<KeyType, ValueType, Compare, Balance>;
+
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using aggregate_type = typename Balance::aggregate_type;
+  using const_iterator = typename Items::const_iterator;
+
+  explicit AggregateTreeMap(const Compare& compare = Compare()) : items(compare)
+  {}
+
+  AggregateTreeMap(std::initializer_list<value_type> list)
+  {
+    for(auto&& entry : list) {
+        insert(entry.first, entry.second);
+    }
+  }
+
+  bool isEmpty() const
+  {
+    return items.isEmpty();
+  }
+
+  size_type getSize() const
+  {
+    return items.getSize();
+  }
+
+  // adds the item or replaces the value of an existing key
+  void insert(const key_type& key, const mapped_type& value)
+  {
+    items.insert_or_assign(key, value);
+  }
+
+  void remove(const key_type& key)
+  {
+    items.remove(key);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    items.remove(it);
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    return items.valueOf(key);
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return items.find(key);
+  }
+
+  const_iterator lower_bound(const key_type& key) const
+  {
+    return items.lower_bound(key);
+  }
+
+  // fold of all values in key order
+  aggregate_type aggregate() const
+  {
+    return items.query([](const auto* root, const Compare&) { return Balance::aggregateOf(root); });
+  }
+
+  // fold of values with keys in [lo, hi)
+  aggregate_type aggregate(const key_type& lo, const key_type& hi) const
+  {
+    return items.query([&](const auto* root, const Compare& compare) {
+        return Balance::aggregate(root, lo, hi, compare);
+    });
+  }
+
+  bool operator==(const AggregateTreeMap& other) const
+  {
+    return items == other.items;
+  }
+
+  bool operator!=(const AggregateTreeMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  const_iterator cbegin() const
+  {
+    return items.cbegin();
+  }
+
+  const_iterator cend() const
+  {
+    return items.cend();
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    Items items;
+};
+
+}
+
+#endif /* AISDI_MAPS_AGGREGATETREEMAP_H */
@@ -0,0 +1,384 @@
+#ifndef AISDI_MAPS_BENCHMARK_H
+#define AISDI_MAPS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
+
+namespace aisdi
+{
+
+// Cost of one benchmark case in nanoseconds per operation.
+// Median and median absolute deviation are used since a single preempted trial would skew a mean.
+struct BenchmarkResult
+{
+  std::string engine;
+  std::string operation;
+  std::size_t operations; //per trial, the timings are divided by it
+  double median;
+  double mad;
+  std::vector<double> samples; //ns/op of every timed trial
+  PerfSample counters; //hardware events per operation over all timed trials
+};
+
+struct LatencyResult
+{
+  std::string engine;
+  std::string operation;
+  LatencyHistogram histogram; //in LatencyClock ticks
+};
+
+class Benchmark
+{
+public:
+  explicit Benchmark(unsigned int warmupRuns = 2, unsigned int trialRuns = 9, std::ostream& output = std::cout)
+    : warmupRuns(warmupRuns), trialRuns(std::max(1u, trialRuns)), output(output)
+  {}
+
+  // nanoseconds spent in body, which is also the region PerfCounters count while open
+  template <typename Body>
+  static double time(Body&& body)
+  {
+    PerfCounters& counters = PerfCounters::instance();
+    counters.start();
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const auto stop = std::chrono::steady_clock::now();
+    counters.stop();
+    return std::chrono::duration<double, std::nano>(stop - start).count();
+  }
+
+  // trial prepares its own data, times the measured part with time() and returns the nanoseconds;
+  // it is called warmupRuns times unreported, then trialRuns times
+  template <typename Trial>
+  const BenchmarkResult& run(const std::string& engine, const std::string& operation, std::size_t operations,
+                             Trial&& trial)
+  {
+    for(unsigned int i = 0; i < warmupRuns; ++i)
+        trial();
+
+    BenchmarkResult result{ engine, operation, operations, 0, 0, {}, {} };
+    PerfCounters::instance().reset();
+    for(unsigned int i = 0; i < trialRuns; ++i)
+        result.samples.push_back(trial() / std::max<std::size_t>(1, operations));
+    result.counters = PerfCounters::instance().read();
+    for(double& count : result.counters.values)
+        count /= static_cast<double>(trialRuns) * std::max<std::size_t>(1, operations);
+
+    result.median = median(result.samples);
+    std::vector<double> deviations;
+    for(double sample : result.samples)
+        deviations.push_back(std::fabs(sample - result.median));
+    result.mad = median(deviations);
+
+    results.push_back(result);
+    report(results.back());
+    return results.back();
+  }
+
+  // tail latencies: trial times single operations (or small batches) into the histogram of their kind,
+  // histograms of all timed trials are merged and reported per operation
+  template <typename Trial>
+  void runLatency(const std::string& engine, const std::vector<std::string>& operations, Trial&& trial)
+  {
+    for(unsigned int i = 0; i < warmupRuns; ++i) {
+        std::vector<LatencyHistogram> discarded(operations.size());
+        trial(discarded);
+    }
+
+    std::vector<LatencyHistogram> histograms(operations.size());
+    for(unsigned int i = 0; i < trialRuns; ++i)
+        trial(histograms);
+
+    for(std::size_t i = 0; i < operations.size(); ++i) {
+        if(histograms[i].getCount() == 0)
+            continue;
+        latencies.push_back({ engine, operations[i], histograms[i] });
+        report(latencies.back());
+    }
+  }
+
+  const std::vector<BenchmarkResult>& getResults() const
+  {
+    return results;
+  }
+
+  const std::vector<LatencyResult>& getLatencies() const
+  {
+    return latencies;
+  }
+
+  // one row per operation measured on baseline, giving every engine's speedup over it
+  void compare(const std::string& baseline) const
+  {
+    std::vector<std::string> engines, operations;
+    for(const BenchmarkResult& result : results)
+        if(result.engine == baseline)
+            operations.push_back(result.operation);
+    if(operations.empty())
+        return;
+    for(const BenchmarkResult& result : results)
+        if(std::find(engines.begin(), engines.end(), result.engine) == engines.end() &&
+           std::find(operations.begin(), operations.end(), result.operation) != operations.end())
+            engines.push_back(result.engine);
+
+    output << std::endl << "Speedup over " << baseline << std::endl << std::left << std::setw(24) << "";
+    for(const std::string& engine : engines)
+        output << std::right << std::setw(columnWidth(engine)) << engine;
+    output << std::endl;
+
+    for(const std::string& operation : operations) {
+        const double reference = find(baseline, operation)->median;
+        output << std::left << std::setw(24) << operation << std::right << std::defaultfloat << std::setprecision(3);
+        for(const std::string& engine : engines) {
+            const BenchmarkResult* result = find(engine, operation);
+            if(result == nullptr || result->median <= 0)
+                output << std::setw(columnWidth(engine)) << "-";
+            else
+                output << std::setw(columnWidth(engine) - 1) << reference / result->median << "x";
+        }
+        output << std::endl;
+    }
+  }
+
+  // hardware events per operation of every result, "-" where an event was not counted
+  void printCounters() const
+  {
+    output << std::endl << "Hardware counters per operation" << std::endl
+           << std::left << std::setw(48) << "" << std::right;
+    for(std::size_t i = 0; i < PerfSample::size; ++i)
+        output << std::setw(14) << PerfSample::name(i);
+    output << std::setw(8) << "IPC" << std::endl;
+
+    for(const BenchmarkResult& result : results) {
+        if(result.counters.empty())
+            continue;
+        output << std::left << std::setw(48) << ("[ " + result.engine + " " + result.operation + " ]") << std::right
+               << std::fixed << std::setprecision(2);
+        for(double count : result.counters.values)
+            printCount(count, 14);
+        printCount(result.counters[PerfEvent::Instructions] / result.counters[PerfEvent::Cycles], 8);
+        output << std::endl;
+    }
+  }
+
+  // every result as a JSON array; events that were not counted are null
+  void writeJson(std::ostream& json) const
+  {
+    json << "[" << std::endl << std::setprecision(6) << std::defaultfloat;
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        json << "  {\"engine\": " << quoted(result.engine) << ", \"operation\": " << quoted(result.operation)
+             << ", \"operations\": " << result.operations
+             << ", \"ns_per_op\": " << result.median << ", \"mad\": " << result.mad << ", \"samples\": [";
+        for(std::size_t j = 0; j < result.samples.size(); ++j)
+            json << (j == 0 ? "" : ", ") << result.samples[j];
+        json << "], \"counters_per_op\": {";
+        for(std::size_t j = 0; j < PerfSample::size; ++j) {
+            json << (j == 0 ? "" : ", ") << "\"" << PerfSample::name(j) << "\": ";
+            if(std::isnan(result.counters.values[j]))
+                json << "null";
+            else
+                json << result.counters.values[j];
+        }
+        json << "}}" << (i + 1 == results.size() ? "" : ",") << std::endl;
+    }
+    json << "]" << std::endl;
+  }
+
+  // results as written by writeJson(); counters are not read back
+  static std::vector<BenchmarkResult> readJson(std::istream& json)
+  {
+    const std::string text((std::istreambuf_iterator<char>(json)), std::istreambuf_iterator<char>());
+    std::size_t position = 0;
+    std::vector<BenchmarkResult> read;
+
+    expect(text, position, '[');
+    while(!consume(text, position, ']')) {
+        if(!read.empty())
+            expect(text, position, ',');
+        BenchmarkResult result{ "", "", 0, 0, 0, {}, {} };
+        expect(text, position, '{');
+        while(!consume(text, position, '}')) {
+            if(consume(text, position, ','))
+                continue;
+            const std::string key = parseString(text, position);
+            expect(text, position, ':');
+            if(key == "engine")
+                result.engine = parseString(text, position);
+            else if(key == "operation")
+                result.operation = parseString(text, position);
+            else if(key == "operations")
+                result.operations = static_cast<std::size_t>(parseNumber(text, position));
+            else if(key == "ns_per_op")
+                result.median = parseNumber(text, position);
+            else if(key == "mad")
+                result.mad = parseNumber(text, position);
+            else if(key == "samples") {
+                expect(text, position, '[');
+                while(!consume(text, position, ']')) {
+                    consume(text, position, ',');
+                    result.samples.push_back(parseNumber(text, position));
+                }
+            }
+            else
+                skipValue(text, position);
+        }
+        read.push_back(result);
+    }
+    return read;
+  }
+
+private:
+    unsigned int warmupRuns;
+    unsigned int trialRuns;
+    std::ostream& output;
+    std::vector<BenchmarkResult> results;
+    std::vector<LatencyResult> latencies;
+
+    const BenchmarkResult* find(const std::string& engine, const std::string& operation) const {
+        for(const BenchmarkResult& result : results)
+            if(result.engine == engine && result.operation == operation)
+                return &result;
+        return nullptr;
+    }
+
+    static std::string quoted(const std::string& text) {
+        std::string escaped = "\"";
+        for(char character : text) {
+            if(character == '"' || character == '\\')
+                escaped += '\\';
+            escaped += character;
+        }
+        return escaped + "\"";
+    }
+
+    static void skipSpace(const std::string& text, std::size_t& position) {
+        while(position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+            ++position;
+    }
+
+    static bool consume(const std::string& text, std::size_t& position, char expected) {
+        skipSpace(text, position);
+        if(position < text.size() && text[position] == expected) {
+            ++position;
+            return true;
+        }
+        if(position >= text.size())
+            throw std::runtime_error("Unexpected end of benchmark JSON");
+        return false;
+    }
+
+    static void expect(const std::string& text, std::size_t& position, char expected) {
+        if(!consume(text, position, expected))
+            throw std::runtime_error(std::string("Expected '") + expected + "' in benchmark JSON at offset "
+                                     + std::to_string(position));
+    }
+
+    static std::string parseString(const std::string& text, std::size_t& position) {
+        expect(text, position, '"');
+        std::string parsed;
+        while(position < text.size() && text[position] != '"') {
+            if(text[position] == '\\')
+                ++position;
+            if(position < text.size())
+                parsed += text[position++];
+        }
+        expect(text, position, '"');
+        return parsed;
+    }
+
+    // null stands for a value that was not measured
+    static double parseNumber(const std::string& text, std::size_t& position) {
+        skipSpace(text, position);
+        if(text.compare(position, 4, "null") == 0) {
+            position += 4;
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        const char* begin = text.c_str() + position;
+        char* end = nullptr;
+        const double parsed = std::strtod(begin, &end);
+        if(end == begin)
+            throw std::runtime_error("Expected a number in benchmark JSON at offset " + std::to_string(position));
+        position += end - begin;
+        return parsed;
+    }
+
+    static void skipValue(const std::string& text, std::size_t& position) {
+        skipSpace(text, position);
+        if(position >= text.size())
+            throw std::runtime_error("Unexpected end of benchmark JSON");
+        if(text[position] == '"') {
+            parseString(text, position);
+            return;
+        }
+        if(text[position] != '[' && text[position] != '{') {
+            while(position < text.size() && text[position] != ',' && text[position] != '}' && text[position] != ']')
+                ++position;
+            return;
+        }
+        const char close = text[position] == '[' ? ']' : '}';
+        ++position;
+        while(!consume(text, position, close)) {
+            consume(text, position, ',');
+            if(close == '}') {
+                parseString(text, position);
+                expect(text, position, ':');
+            }
+            skipValue(text, position);
+        }
+    }
+
+    void printCount(double count, int width) const {
+        if(std::isnan(count) || std::isinf(count))
+            output << std::setw(width) << "-";
+        else
+            output << std::setw(width) << count;
+    }
+
+    static int columnWidth(const std::string& engine) {
+        return std::max<int>(10, engine.size() + 2);
+    }
+
+    static double median(std::vector<double> values) {
+        const std::size_t middle = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + middle, values.end());
+        if(values.size() % 2 == 1)
+            return values[middle];
+        return (values[middle] + *std::max_element(values.begin(), values.begin() + middle)) / 2;
+    }
+
+    void report(const BenchmarkResult& result) const {
+        output << std::left << std::setw(48) << ("[ " + result.engine + " " + result.operation + " ]") << std::right
+               << std::fixed << std::setprecision(1)
+               << std::setw(12) << result.median << " ns/op  +- "
+               << std::setw(8) << result.mad << " MAD" << std::endl;
+    }
+
+    void report(const LatencyResult& result) const {
+        const double scale = LatencyClock::nanosecondsPerTick();
+        output << std::left << std::setw(48) << ("[ " + result.engine + " " + result.operation + " ]") << std::right
+               << std::fixed << std::setprecision(0)
+               << " p50 " << std::setw(8) << result.histogram.percentile(50) * scale
+               << "  p99 " << std::setw(8) << result.histogram.percentile(99) * scale
+               << "  p99.9 " << std::setw(9) << result.histogram.percentile(99.9) * scale
+               << "  max " << std::setw(10) << result.histogram.max() * scale << " ns" << std::endl;
+    }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_BENCHMARK_H */
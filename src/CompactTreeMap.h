@@ -0,0 +1,778 @@
+#ifndef AISDI_MAPS_COMPACTTREEMAP_H
+#define AISDI_MAPS_COMPACTTREEMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace aisdi
+{
+
+// AVL tree with nodes kept in one contiguous pool and linked by 32-bit indices.
+// The balance factor lives in the top two bits of the parent index, freed slots are reused.
+// Growing the pool moves items like std::vector does: iterators stay valid, references do not.
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+class CompactTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+private:
+    using Index = std::uint32_t;
+
+    struct Slot;
+
+    static const Index none = (Index(1) << 30) - 1;
+    static const Index freeSlot = ~Index(0); //parentAndBalance of unused slots
+
+    std::unique_ptr<Slot[]> slots;
+    Index capacity;
+    Index used; //slots handed out so far
+    Index freeList; //chained through left
+    Index root;
+    size_type size;
+    Compare compare;
+
+public:
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  CompactTreeMap() : capacity(0), used(0), freeList(none), root(none), size(0)
+  {}
+
+  explicit CompactTreeMap(const Compare& compare) : CompactTreeMap()
+  {
+    this->compare = compare;
+  }
+
+  CompactTreeMap(std::initializer_list<value_type> list) : CompactTreeMap()
+  {
+    for(auto&& entry : list) {
+        (*this)[entry.first] = entry.second;
+    }
+  }
+
+  CompactTreeMap(const CompactTreeMap& other) : CompactTreeMap(other.compare)
+  {
+    for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
+        (*this)[it->first] = it->second;
+    }
+  }
+
+  CompactTreeMap(CompactTreeMap&& other) : CompactTreeMap(other.compare)
+  {
+    swap(other);
+  }
+
+  ~CompactTreeMap()
+  {
+    releaseAll();
+  }
+
+  CompactTreeMap& operator=(const CompactTreeMap& other)
+  {
+    if(this == &other) return *this;
+
+    CompactTreeMap copy(other);
+    swap(copy);
+    return *this;
+  }
+
+  CompactTreeMap& operator=(CompactTreeMap&& other)
+  {
+    if(this == &other) return *this;
+
+    releaseAll();
+    slots.reset();
+    capacity = used = 0;
+    freeList = root = none;
+    size = 0;
+    swap(other);
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  // makes room for count items, so that inserting them moves nothing
+  void reserve(size_type count)
+  {
+    if(count > capacity)
+        grow(count);
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    return value(insert(key)).second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    Index tmp = findKey(key);
+    if(tmp == none)
+        throw std::out_of_range("No such element");
+    return value(tmp).second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    Index tmp = findKey(key);
+    if(tmp == none)
+        throw std::out_of_range("No such element");
+    return value(tmp).second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(this, findKey(key));
+  }
+
+  iterator find(const key_type& key)
+  {
+    return Iterator(ConstIterator(this, findKey(key)));
+  }
+
+  // first item with key not less than the given one
+  const_iterator lower_bound(const key_type& key) const
+  {
+    return ConstIterator(this, lowerBound(key));
+  }
+
+  iterator lower_bound(const key_type& key)
+  {
+    return Iterator(ConstIterator(this, lowerBound(key)));
+  }
+
+  void remove(const key_type& key)
+  {
+    Index tmp = findKey(key);
+    if(tmp == none)
+        throw std::out_of_range("No such element");
+    erase(tmp);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it.current == none)
+        throw std::out_of_range("No such element");
+    erase(it.current);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const CompactTreeMap& other) const
+  {
+    if(size != other.size) return false;
+
+    for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
+        Index tmp = findKey(it->first);
+        if(tmp == none || value(tmp).second != it->second) return false;
+    }
+
+    return true;
+  }
+
+  bool operator!=(const CompactTreeMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return Iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    return ConstIterator(this, root == none ? none : leftmostOf(root));
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, none);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    Slot& at(Index i) const {
+        return slots[i];
+    }
+
+    value_type& value(Index i) const {
+        return *reinterpret_cast<value_type*>(&at(i).storage);
+    }
+
+    const key_type& keyOf(Index i) const {
+        return value(i).first;
+    }
+
+    Index& left(Index i) const {
+        return at(i).left;
+    }
+
+    Index& right(Index i) const {
+        return at(i).right;
+    }
+
+    Index parent(Index i) const {
+        return at(i).parentAndBalance & none;
+    }
+
+    void setParent(Index i, Index p) {
+        at(i).parentAndBalance = (at(i).parentAndBalance & ~none) | p;
+    }
+
+    // height of right subtree minus height of left one, stored as 0..2
+    int balance(Index i) const {
+        return static_cast<int>(at(i).parentAndBalance >> 30) - 1;
+    }
+
+    void setBalance(Index i, int b) {
+        at(i).parentAndBalance = (at(i).parentAndBalance & none) | (Index(b + 1) << 30);
+    }
+
+    void swap(CompactTreeMap& other) {
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(used, other.used);
+        std::swap(freeList, other.freeList);
+        std::swap(root, other.root);
+        std::swap(size, other.size);
+        std::swap(compare, other.compare);
+    }
+
+    Index allocate(const key_type& key) {
+        Index i = freeList;
+        if(i != none) freeList = left(i);
+        else {
+            if(used == none)
+                throw std::length_error("CompactTreeMap is full");
+            if(used == capacity)
+                grow(capacity < 8 ? 16 : 2 * size_type(capacity));
+            i = used++;
+        }
+
+        try {
+            new(&at(i).storage) value_type(key, mapped_type());
+        } catch(...) {
+            left(i) = freeList;
+            at(i).parentAndBalance = freeSlot;
+            freeList = i;
+            throw;
+        }
+
+        left(i) = right(i) = none;
+        at(i).parentAndBalance = none;
+        setBalance(i, 0);
+        return i;
+    }
+
+    void release(Index i) {
+        value(i).~value_type();
+        left(i) = freeList;
+        at(i).parentAndBalance = freeSlot;
+        freeList = i;
+    }
+
+    // items are moved when that cannot throw, copied otherwise, so a failure leaves the pool intact
+    void grow(size_type count) {
+        Index newCapacity = count < none ? Index(count) : none;
+        std::unique_ptr<Slot[]> moved(new Slot[newCapacity]);
+
+        Index i = 0;
+        try {
+            for(; i < used; ++i) {
+                moved[i].left = slots[i].left;
+                moved[i].right = slots[i].right;
+                moved[i].parentAndBalance = slots[i].parentAndBalance;
+                if(slots[i].parentAndBalance != freeSlot)
+                    new(&moved[i].storage) value_type(std::move_if_noexcept(value(i)));
+            }
+        } catch(...) {
+            while(i-- > 0)
+                if(moved[i].parentAndBalance != freeSlot)
+                    reinterpret_cast<value_type*>(&moved[i].storage)->~value_type();
+            throw;
+        }
+
+        for(i = 0; i < used; ++i)
+            if(slots[i].parentAndBalance != freeSlot) value(i).~value_type();
+
+        slots.swap(moved);
+        capacity = newCapacity;
+    }
+
+    // links of the tree stay intact, only the items are destroyed
+    void releaseAll() {
+        for(Index i = root == none ? none : leftmostOf(root); i != none;) {
+            Index next = successorOf(i);
+            value(i).~value_type();
+            i = next;
+        }
+    }
+
+    Index leftmostOf(Index i) const {
+        while(left(i) != none)
+            i = left(i);
+        return i;
+    }
+
+    Index rightmostOf(Index i) const {
+        while(right(i) != none)
+            i = right(i);
+        return i;
+    }
+
+    Index successorOf(Index i) const {
+        if(right(i) != none) return leftmostOf(right(i));
+
+        Index p = parent(i);
+        while(p != none && right(p) == i) {
+            i = p;
+            p = parent(p);
+        }
+        return p;
+    }
+
+    Index predecessorOf(Index i) const {
+        if(left(i) != none) return rightmostOf(left(i));
+
+        Index p = parent(i);
+        while(p != none && left(p) == i) {
+            i = p;
+            p = parent(p);
+        }
+        return p;
+    }
+
+    Index lowerBound(const key_type& key) const {
+        Index current = root;
+        Index bound = none;
+        while(current != none) {
+            if(compare(keyOf(current), key))
+                current = right(current);
+            else {
+                bound = current;
+                current = left(current);
+            }
+        }
+        return bound;
+    }
+
+    Index findKey(const key_type& key) const {
+        Index bound = lowerBound(key);
+        if(bound == none || compare(key, keyOf(bound))) return none;
+        return bound;
+    }
+
+    Index insert(const key_type& key) {
+        Index current = root;
+        Index p = none;
+        Index bound = none;
+        bool asLeft = false;
+        while(current != none) {
+            p = current;
+            asLeft = !compare(keyOf(current), key);
+            if(asLeft) bound = current;
+            current = asLeft ? left(current) : right(current);
+        }
+
+        if(bound != none && !compare(key, keyOf(bound))) return bound;
+
+        Index created = allocate(key);
+        setParent(created, p);
+        if(p == none) root = created;
+        else if(asLeft) left(p) = created;
+        else right(p) = created;
+
+        ++size;
+        retraceAfterInsertion(created);
+        return created;
+    }
+
+    void erase(Index d) {
+        if(left(d) != none && right(d) != none)
+            swapWithSuccessor(d, leftmostOf(right(d)));
+
+        Index child = left(d) != none ? left(d) : right(d);
+        Index p = parent(d);
+        bool fromLeft = p != none && left(p) == d;
+
+        if(child != none) setParent(child, p);
+        replaceChild(p, d, child);
+
+        release(d);
+        --size;
+        retraceAfterRemoval(p, fromLeft);
+    }
+
+    // moves s, the leftmost node of d's right subtree, into d's place and d into s's
+    void swapWithSuccessor(Index d, Index s) {
+        Index dp = parent(d), dl = left(d), dr = right(d);
+        Index sp = parent(s), sr = right(s);
+        int db = balance(d), sb = balance(s);
+
+        replaceChild(dp, d, s);
+        setParent(s, dp);
+        setBalance(s, db);
+        left(s) = dl;
+        setParent(dl, s);
+
+        if(sp == d) {
+            right(s) = d;
+            setParent(d, s);
+        } else {
+            right(s) = dr;
+            setParent(dr, s);
+            left(sp) = d;
+            setParent(d, sp);
+        }
+
+        left(d) = none;
+        right(d) = sr;
+        if(sr != none) setParent(sr, d);
+        setBalance(d, sb);
+    }
+
+    void replaceChild(Index p, Index oldChild, Index newChild) {
+        if(p == none) root = newChild;
+        else if(left(p) == oldChild) left(p) = newChild;
+        else right(p) = newChild;
+    }
+
+    void retraceAfterInsertion(Index z) {
+        for(Index x = parent(z); x != none; z = x, x = parent(z)) {
+            Index g = parent(x);
+            Index n;
+
+            if(z == right(x)) {
+                if(balance(x) < 0) {
+                    setBalance(x, 0);
+                    return;
+                }
+                if(balance(x) == 0) {
+                    setBalance(x, 1);
+                    continue;
+                }
+                n = balance(z) < 0 ? rotateRightLeft(x, z) : rotateLeft(x, z);
+            } else {
+                if(balance(x) > 0) {
+                    setBalance(x, 0);
+                    return;
+                }
+                if(balance(x) == 0) {
+                    setBalance(x, -1);
+                    continue;
+                }
+                n = balance(z) > 0 ? rotateLeftRight(x, z) : rotateRight(x, z);
+            }
+
+            replaceChild(g, x, n);
+            setParent(n, g);
+            return;
+        }
+    }
+
+    // subtree on the fromLeft side of x got one level lower
+    void retraceAfterRemoval(Index x, bool fromLeft) {
+        while(x != none) {
+            Index g = parent(x);
+            bool xIsLeft = g != none && left(g) == x;
+            Index n;
+            int b;
+
+            if(fromLeft) {
+                if(balance(x) == 0) {
+                    setBalance(x, 1);
+                    return;
+                }
+                if(balance(x) < 0) {
+                    setBalance(x, 0);
+                    x = g;
+                    fromLeft = xIsLeft;
+                    continue;
+                }
+                Index z = right(x);
+                b = balance(z);
+                n = b < 0 ? rotateRightLeft(x, z) : rotateLeft(x, z);
+            } else {
+                if(balance(x) == 0) {
+                    setBalance(x, -1);
+                    return;
+                }
+                if(balance(x) > 0) {
+                    setBalance(x, 0);
+                    x = g;
+                    fromLeft = xIsLeft;
+                    continue;
+                }
+                Index z = left(x);
+                b = balance(z);
+                n = b > 0 ? rotateLeftRight(x, z) : rotateRight(x, z);
+            }
+
+            replaceChild(g, x, n);
+            setParent(n, g);
+            if(b == 0) return; //height did not change
+            x = g;
+            fromLeft = xIsLeft;
+        }
+    }
+
+    // rotations return the new subtree root, hooking it to the old parent is left to the caller
+    Index rotateLeft(Index x, Index z) {
+        Index inner = left(z);
+        right(x) = inner;
+        if(inner != none) setParent(inner, x);
+
+        left(z) = x;
+        setParent(x, z);
+
+        if(balance(z) == 0) { //only after removal
+            setBalance(x, 1);
+            setBalance(z, -1);
+        } else {
+            setBalance(x, 0);
+            setBalance(z, 0);
+        }
+        return z;
+    }
+
+    Index rotateRight(Index x, Index z) {
+        Index inner = right(z);
+        left(x) = inner;
+        if(inner != none) setParent(inner, x);
+
+        right(z) = x;
+        setParent(x, z);
+
+        if(balance(z) == 0) {
+            setBalance(x, -1);
+            setBalance(z, 1);
+        } else {
+            setBalance(x, 0);
+            setBalance(z, 0);
+        }
+        return z;
+    }
+
+    Index rotateRightLeft(Index x, Index z) {
+        Index y = left(z);
+        Index t3 = right(y);
+        left(z) = t3;
+        if(t3 != none) setParent(t3, z);
+        right(y) = z;
+        setParent(z, y);
+
+        Index t2 = left(y);
+        right(x) = t2;
+        if(t2 != none) setParent(t2, x);
+        left(y) = x;
+        setParent(x, y);
+
+        setBalance(x, balance(y) > 0 ? -1 : 0);
+        setBalance(z, balance(y) < 0 ? 1 : 0);
+        setBalance(y, 0);
+        return y;
+    }
+
+    Index rotateLeftRight(Index x, Index z) {
+        Index y = right(z);
+        Index t3 = left(y);
+        right(z) = t3;
+        if(t3 != none) setParent(t3, z);
+        left(y) = z;
+        setParent(z, y);
+
+        Index t2 = right(y);
+        left(x) = t2;
+        if(t2 != none) setParent(t2, x);
+        right(y) = x;
+        setParent(x, y);
+
+        setBalance(x, balance(y) < 0 ? 1 : 0);
+        setBalance(z, balance(y) > 0 ? -1 : 0);
+        setBalance(y, 0);
+        return y;
+    }
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+struct CompactTreeMap<KeyType, ValueType, Compare>::Slot
+{
+    Index left, right; //left chains free slots
+    Index parentAndBalance;
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+class CompactTreeMap<KeyType, ValueType, Compare>::ConstIterator
+{
+    friend class CompactTreeMap;
+
+    const CompactTreeMap *map;
+    Index current; //none at end
+
+    ConstIterator(const CompactTreeMap *map, Index current) : map(map), current(current)
+    {}
+
+public:
+  using reference = typename CompactTreeMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename CompactTreeMap::value_type;
+  using pointer = const typename CompactTreeMap::value_type*;
+  using difference_type = std::ptrdiff_t;
+
+  explicit ConstIterator() : map(nullptr), current(CompactTreeMap::none)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(map == nullptr || current == CompactTreeMap::none)
+        throw std::out_of_range("No access");
+
+    current = map->successorOf(current);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator it(*this);
+    ++(*this);
+    return it;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(map == nullptr || map->root == CompactTreeMap::none)
+        throw std::out_of_range("No access");
+
+    if(current == CompactTreeMap::none) {
+        current = map->rightmostOf(map->root);
+        return *this;
+    }
+
+    Index previous = map->predecessorOf(current);
+    if(previous == CompactTreeMap::none)
+        throw std::out_of_range("No access"); //begin
+    current = previous;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator it(*this);
+    --(*this);
+    return it;
+  }
+
+  reference operator*() const
+  {
+    if(map == nullptr || current == CompactTreeMap::none)
+        throw std::out_of_range("No access");
+    return map->value(current);
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return map == other.map && current == other.current;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+class CompactTreeMap<KeyType, ValueType, Compare>::Iterator : public CompactTreeMap<KeyType, ValueType, Compare>::ConstIterator
+{
+public:
+  using reference = typename CompactTreeMap::reference;
+  using pointer = typename CompactTreeMap::value_type*;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_COMPACTTREEMAP_H */
@@ -0,0 +1,119 @@
+#ifndef AISDI_MAPS_COMPLEXITYFIT_H
+#define AISDI_MAPS_COMPLEXITYFIT_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace aisdi
+{
+
+enum class Complexity
+{
+  Constant,
+  Logarithmic,
+  SquareRoot,
+  Linear,
+  Linearithmic,
+  Quadratic
+};
+
+// Growth of a per-operation cost with the size of the collection: the model c * f(n) closest to
+// the measurements on a log scale, so relative rather than absolute errors are weighed, and the
+// slope of log cost over log size, which shows growth the candidate models do not describe.
+struct ComplexityEstimate
+{
+  Complexity complexity;
+  double coefficient;
+  double exponent;
+  double error; //mean squared residual of the chosen model in natural log units
+
+  static const char* name(Complexity complexity)
+  {
+    switch(complexity) {
+    case Complexity::Constant:
+        return "O(1)";
+    case Complexity::Logarithmic:
+        return "O(log n)";
+    case Complexity::SquareRoot:
+        return "O(sqrt n)";
+    case Complexity::Linear:
+        return "O(n)";
+    case Complexity::Linearithmic:
+        return "O(n log n)";
+    case Complexity::Quadratic:
+        return "O(n^2)";
+    }
+    return "?";
+  }
+
+  static double model(Complexity complexity, double size)
+  {
+    switch(complexity) {
+    case Complexity::Constant:
+        return 1;
+    case Complexity::Logarithmic:
+        return std::log2(size);
+    case Complexity::SquareRoot:
+        return std::sqrt(size);
+    case Complexity::Linear:
+        return size;
+    case Complexity::Linearithmic:
+        return size * std::log2(size);
+    case Complexity::Quadratic:
+        return size * size;
+    }
+    return 1;
+  }
+};
+
+// costs[i] was measured at sizes[i]; needs two distinct sizes above 1 and positive costs
+inline ComplexityEstimate fitComplexity(const std::vector<double>& sizes, const std::vector<double>& costs)
+{
+  if(sizes.size() != costs.size() || sizes.size() < 2)
+      throw std::invalid_argument("Complexity fit needs a cost for each of at least two sizes");
+  for(std::size_t i = 0; i < sizes.size(); ++i)
+      if(!(sizes[i] > 1) || !(costs[i] > 0))
+          throw std::invalid_argument("Complexity fit needs sizes above 1 and positive costs");
+
+  const std::size_t count = sizes.size();
+  double meanSize = 0, meanCost = 0;
+  for(std::size_t i = 0; i < count; ++i) {
+      meanSize += std::log(sizes[i]) / count;
+      meanCost += std::log(costs[i]) / count;
+  }
+  double covariance = 0, variance = 0;
+  for(std::size_t i = 0; i < count; ++i) {
+      covariance += (std::log(sizes[i]) - meanSize) * (std::log(costs[i]) - meanCost);
+      variance += (std::log(sizes[i]) - meanSize) * (std::log(sizes[i]) - meanSize);
+  }
+  if(variance == 0)
+      throw std::invalid_argument("Complexity fit needs at least two distinct sizes");
+
+  ComplexityEstimate best{ Complexity::Constant, 0, covariance / variance, std::numeric_limits<double>::infinity() };
+  for(Complexity complexity : { Complexity::Constant, Complexity::Logarithmic, Complexity::SquareRoot,
+                                Complexity::Linear, Complexity::Linearithmic, Complexity::Quadratic }) {
+      // least squares in log space: log c is the mean distance of the costs from the model
+      double logCoefficient = 0;
+      for(std::size_t i = 0; i < count; ++i)
+          logCoefficient += (std::log(costs[i]) - std::log(ComplexityEstimate::model(complexity, sizes[i]))) / count;
+      double error = 0;
+      for(std::size_t i = 0; i < count; ++i) {
+          const double residual = std::log(costs[i]) - logCoefficient
+                                  - std::log(ComplexityEstimate::model(complexity, sizes[i]));
+          error += residual * residual / count;
+      }
+      if(error < best.error) {
+          best.complexity = complexity;
+          best.coefficient = std::exp(logCoefficient);
+          best.error = error;
+      }
+  }
+  return best;
+}
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_COMPLEXITYFIT_H */
@@ -0,0 +1,590 @@
+#ifndef AISDI_MAPS_CONCURRENTTREEMAP_H
+#define AISDI_MAPS_CONCURRENTTREEMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace aisdi
+{
+
+// Lazy skip list: lookups and iteration take no locks, writers lock only the
+// predecessors of the key they change. Values are immutable and swapped whole.
+// Unlinked nodes and replaced values are reclaimed by epochs: every operation
+// announces the epoch it started in, and memory retired in an epoch is freed once
+// every announcing thread has moved two epochs past it. Live iterators hold all
+// reclamation back until they are destroyed.
+template <typename KeyType, typename ValueType>
+class ConcurrentTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+
+private:
+    struct Node;
+    struct Value;
+    template <typename Item>
+    class RetiredList;
+    class Guard;
+
+    static const int maxLevel = 32;
+    static const int slotCount = 64; //threads inside an operation at once, more wait for a free slot
+    static const unsigned int collectInterval = 64; //retirements of a thread between reclamation attempts
+
+    // one cache line each, so threads announcing their epochs do not share lines
+    struct Slot
+    {
+        std::atomic<std::uint64_t> epoch; //0 when free
+        char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+
+        Slot() : epoch(0) {}
+    };
+
+    Node* head;
+    std::atomic<size_type> size;
+    mutable std::atomic<std::uint64_t> epoch;
+    mutable std::atomic<size_type> iterators;
+    mutable Slot slots[slotCount];
+    RetiredList<Node> retiredNodes;
+    RetiredList<Value> retiredValues;
+
+public:
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+
+  ConcurrentTreeMap() : head(Node::create(key_type(), mapped_type(), maxLevel - 1)), size(0), epoch(1), iterators(0)
+  {}
+
+  ConcurrentTreeMap(std::initializer_list<value_type> list) : ConcurrentTreeMap()
+  {
+    for(auto&& entry : list) {
+        insert(entry.first, entry.second);
+    }
+  }
+
+  ConcurrentTreeMap(const ConcurrentTreeMap& other) = delete;
+  ConcurrentTreeMap& operator=(const ConcurrentTreeMap& other) = delete;
+
+  ~ConcurrentTreeMap()
+  {
+    Node *current = head;
+    while(current != nullptr) {
+        Node *next = current->next(0).load();
+        Node::destroy(current);
+        current = next;
+    }
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  size_type getSize() const
+  {
+    return size.load();
+  }
+
+  // returns false when key was already present and only its value got replaced
+  bool insert(const key_type& key, const mapped_type& value)
+  {
+    Guard guard(*this);
+    Node *preds[maxLevel], *succs[maxLevel];
+    const int topLevel = randomLevel();
+
+    while(true) {
+        int levelFound = findPath(key, preds, succs);
+        if(levelFound != -1) {
+            Node *found = succs[levelFound];
+            if(found->marked.load()) continue;
+
+            while(!found->fullyLinked.load())
+                std::this_thread::yield();
+            retire(retiredValues, found->value.exchange(new Value(value)));
+            return false;
+        }
+
+        int highestLocked = -1;
+        bool valid = true;
+        for(int level = 0; valid && level <= topLevel; ++level) {
+            if(level == 0 || preds[level] != preds[level - 1]) {
+                preds[level]->lock();
+                highestLocked = level;
+            }
+            Node *succ = succs[level];
+            valid = !preds[level]->marked.load() && (succ == nullptr || !succ->marked.load())
+                    && preds[level]->next(level).load() == succ;
+        }
+
+        if(!valid) {
+            unlock(preds, highestLocked);
+            continue;
+        }
+
+        Node *created = Node::create(key, value, topLevel);
+        for(int level = 0; level <= topLevel; ++level)
+            created->next(level).store(succs[level]);
+        for(int level = 0; level <= topLevel; ++level)
+            preds[level]->next(level).store(created);
+        created->fullyLinked.store(true);
+
+        unlock(preds, highestLocked);
+        ++size;
+        return true;
+    }
+  }
+
+  mapped_type valueOf(const key_type& key) const
+  {
+    Guard guard(*this);
+    Node *tmp = findNode(key);
+    if(tmp == nullptr)
+        throw std::out_of_range("No such element");
+    return tmp->value.load()->mapped;
+  }
+
+  bool contains(const key_type& key) const
+  {
+    Guard guard(*this);
+    return findNode(key) != nullptr;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    Guard guard(*this);
+    return ConstIterator(findNode(key), this);
+  }
+
+  void remove(const key_type& key)
+  {
+    if(!tryRemove(key))
+        throw std::out_of_range("No such element");
+  }
+
+  // returns false instead of throwing when key is missing
+  bool tryRemove(const key_type& key)
+  {
+    Guard guard(*this);
+    Node *preds[maxLevel], *succs[maxLevel];
+    Node *victim = nullptr;
+    bool isMarked = false;
+    int topLevel = -1;
+
+    while(true) {
+        int levelFound = findPath(key, preds, succs);
+        if(!isMarked) {
+            if(levelFound == -1 || !canBeRemoved(succs[levelFound], levelFound))
+                return false;
+
+            victim = succs[levelFound];
+            topLevel = victim->topLevel;
+            victim->lock();
+            if(victim->marked.load()) {
+                victim->unlock();
+                return false;
+            }
+            victim->marked.store(true);
+            isMarked = true;
+        }
+
+        int highestLocked = -1;
+        bool valid = true;
+        for(int level = 0; valid && level <= topLevel; ++level) {
+            if(level == 0 || preds[level] != preds[level - 1]) {
+                preds[level]->lock();
+                highestLocked = level;
+            }
+            valid = !preds[level]->marked.load() && preds[level]->next(level).load() == victim;
+        }
+
+        if(!valid) {
+            unlock(preds, highestLocked);
+            continue;
+        }
+
+        for(int level = topLevel; level >= 0; --level)
+            preds[level]->next(level).store(victim->next(level).load());
+
+        victim->unlock();
+        unlock(preds, highestLocked);
+        retire(retiredNodes, victim);
+        --size;
+        return true;
+    }
+  }
+
+  // first item with key not less than the given one
+  const_iterator lower_bound(const key_type& key) const
+  {
+    Guard guard(*this);
+    Node *preds[maxLevel], *succs[maxLevel];
+    findPath(key, preds, succs);
+    return ConstIterator(ConstIterator::skipRemoved(succs[0]), this);
+  }
+
+  const_iterator cbegin() const
+  {
+    Guard guard(*this);
+    return ConstIterator(ConstIterator::skipRemoved(head->next(0).load()), this);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(nullptr);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    static int randomLevel() {
+        thread_local std::minstd_rand generator(std::random_device{}());
+
+        int level = 0;
+        for(auto bits = generator(); (bits & 1) && level < maxLevel - 1; bits >>= 1)
+            ++level;
+        return level;
+    }
+
+    // fills predecessors and successors on every level, returns highest level holding key or -1
+    int findPath(const key_type& key, Node** preds, Node** succs) const {
+        int levelFound = -1;
+        Node *pred = head;
+
+        for(int level = maxLevel - 1; level >= 0; --level) {
+            Node *current = pred->next(level).load();
+            while(current != nullptr && current->key < key) {
+                pred = current;
+                current = pred->next(level).load();
+            }
+
+            if(levelFound == -1 && current != nullptr && !(key < current->key))
+                levelFound = level;
+            preds[level] = pred;
+            succs[level] = current;
+        }
+
+        return levelFound;
+    }
+
+    Node* findNode(const key_type& key) const {
+        Node *pred = head;
+        Node *current = nullptr;
+
+        for(int level = maxLevel - 1; level >= 0; --level) {
+            current = pred->next(level).load();
+            while(current != nullptr && current->key < key) {
+                pred = current;
+                current = pred->next(level).load();
+            }
+
+            if(current != nullptr && !(key < current->key))
+                break;
+        }
+
+        if(current == nullptr || key < current->key) return nullptr;
+        if(!current->fullyLinked.load() || current->marked.load()) return nullptr;
+        return current;
+    }
+
+    static bool canBeRemoved(Node* node, int levelFound) {
+        return node->fullyLinked.load() && node->topLevel == levelFound && !node->marked.load();
+    }
+
+    static void unlock(Node** preds, int highestLocked) {
+        for(int level = 0; level <= highestLocked; ++level) {
+            if(level == 0 || preds[level] != preds[level - 1])
+                preds[level]->unlock();
+        }
+    }
+
+    // claims a free slot announcing the current epoch, starting from one picked by the thread
+    Slot* pin() const {
+        static thread_local const std::size_t home = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        while(true) {
+            for(int i = 0; i < slotCount; ++i) {
+                Slot& slot = slots[(home + i) % slotCount];
+                std::uint64_t free = 0;
+                if(slot.epoch.load() == 0 && slot.epoch.compare_exchange_strong(free, epoch.load()))
+                    return &slot;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    template <typename Item>
+    void retire(RetiredList<Item>& list, Item* item) {
+        item->retiredEpoch = epoch.load();
+        list.push(item);
+
+        static thread_local unsigned int sinceCollect = 0;
+        if(++sinceCollect % collectInterval == 0)
+            collect();
+    }
+
+    // moves to the next epoch when every announced thread is in the current one,
+    // then frees what was retired at least two epochs ago
+    void collect() {
+        std::uint64_t current = epoch.load();
+        bool advance = true;
+        for(const Slot& slot : slots) {
+            const std::uint64_t announced = slot.epoch.load();
+            advance = advance && (announced == 0 || announced == current);
+        }
+        if(advance && epoch.compare_exchange_strong(current, current + 1))
+            ++current;
+
+        if(iterators.load() != 0) return;
+        retiredNodes.collect(current - 1);
+        retiredValues.collect(current - 1);
+    }
+};
+
+// Lock-free stack of retired items, each tagged with the epoch it was retired in.
+template <typename KeyType, typename ValueType>
+template <typename Item>
+class ConcurrentTreeMap<KeyType, ValueType>::RetiredList
+{
+    std::atomic<Item*> top;
+
+    void push(Item* first, Item* last) {
+        last->nextRetired = top.load();
+        while(!top.compare_exchange_weak(last->nextRetired, first))
+        {}
+    }
+
+public:
+  RetiredList() : top(nullptr)
+  {}
+
+  RetiredList(const RetiredList&) = delete;
+  RetiredList& operator=(const RetiredList&) = delete;
+
+  ~RetiredList()
+  {
+    collect(std::numeric_limits<std::uint64_t>::max());
+  }
+
+  void push(Item* item)
+  {
+    push(item, item);
+  }
+
+  // frees items retired before the given epoch, the rest goes back on the stack
+  void collect(std::uint64_t before)
+  {
+    Item *kept = nullptr, *lastKept = nullptr;
+    Item *current = top.exchange(nullptr);
+    while(current != nullptr) {
+        Item *next = current->nextRetired;
+        if(current->retiredEpoch < before)
+            Item::destroy(current);
+        else {
+            current->nextRetired = kept;
+            kept = current;
+            if(lastKept == nullptr) lastKept = current;
+        }
+        current = next;
+    }
+    if(kept != nullptr)
+        push(kept, lastKept);
+  }
+};
+
+// Announces the current epoch while alive, nothing retired meanwhile is freed.
+template <typename KeyType, typename ValueType>
+class ConcurrentTreeMap<KeyType, ValueType>::Guard
+{
+    Slot *slot;
+
+public:
+  explicit Guard(const ConcurrentTreeMap& map) : slot(map.pin())
+  {}
+
+  Guard(const Guard&) = delete;
+  Guard& operator=(const Guard&) = delete;
+
+  ~Guard()
+  {
+    slot->epoch.store(0);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+struct ConcurrentTreeMap<KeyType, ValueType>::Value
+{
+    const mapped_type mapped;
+    Value *nextRetired;
+    std::uint64_t retiredEpoch;
+
+    explicit Value(const mapped_type& mapped) : mapped(mapped), nextRetired(nullptr), retiredEpoch(0) {}
+
+    static void destroy(Value* value) {
+        delete value;
+    }
+};
+
+// The tower of next pointers is allocated right behind the node.
+template <typename KeyType, typename ValueType>
+struct ConcurrentTreeMap<KeyType, ValueType>::Node
+{
+    const key_type key;
+    std::atomic<Value*> value; //replaced whole, the old one is retired
+    const int topLevel;
+    std::atomic<bool> locked, marked, fullyLinked;
+    Node *nextRetired;
+    std::uint64_t retiredEpoch;
+
+    static Node* create(const key_type& key, const mapped_type& mapped_value, int topLevel) {
+        void *memory = ::operator new(sizeof(Node) + (topLevel + 1) * sizeof(std::atomic<Node*>));
+        Node *node = new(memory) Node(key, mapped_value, topLevel);
+        for(int level = 0; level <= topLevel; ++level)
+            new(&node->next(level)) std::atomic<Node*>(nullptr);
+        return node;
+    }
+
+    static void destroy(Node* node) {
+        node->~Node();
+        ::operator delete(node);
+    }
+
+    std::atomic<Node*>& next(int level) {
+        return reinterpret_cast<std::atomic<Node*>*>(this + 1)[level];
+    }
+
+    void lock() {
+        while(locked.exchange(true, std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    void unlock() {
+        locked.store(false, std::memory_order_release);
+    }
+
+private:
+    Node(const key_type& key, const mapped_type& mapped_value, int topLevel)
+        : key(key), value(new Value(mapped_value)), topLevel(topLevel),
+          locked(false), marked(false), fullyLinked(false), nextRetired(nullptr), retiredEpoch(0) {}
+
+    ~Node() {
+        delete value.load();
+    }
+};
+
+// Weakly consistent: sees every item present for the whole traversal,
+// items changed meanwhile may or may not be visited.
+// While an iterator of a map exists, nothing the map retires is freed.
+template <typename KeyType, typename ValueType>
+class ConcurrentTreeMap<KeyType, ValueType>::ConstIterator
+{
+    friend class ConcurrentTreeMap;
+
+    Node *current;
+    const ConcurrentTreeMap *map; //counted in its iterators, nullptr for end
+
+    void release() {
+        if(map != nullptr)
+            --map->iterators;
+    }
+
+    static Node* skipRemoved(Node* node) {
+        while(node != nullptr && (node->marked.load() || !node->fullyLinked.load()))
+            node = node->next(0).load();
+        return node;
+    }
+
+public:
+  using reference = typename ConcurrentTreeMap::value_type;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename ConcurrentTreeMap::value_type;
+  using pointer = void;
+  using difference_type = std::ptrdiff_t;
+
+  explicit ConstIterator(Node *current = nullptr, const ConcurrentTreeMap* map = nullptr) : current(current), map(map)
+  {
+    if(map != nullptr)
+        ++map->iterators;
+  }
+
+  ConstIterator(const ConstIterator& other) : ConstIterator(other.current, other.map)
+  {}
+
+  ConstIterator& operator=(const ConstIterator& other)
+  {
+    if(other.map != nullptr)
+        ++other.map->iterators;
+    release();
+    current = other.current;
+    map = other.map;
+    return *this;
+  }
+
+  ~ConstIterator()
+  {
+    release();
+  }
+
+  ConstIterator& operator++()
+  {
+    if(current == nullptr)
+        throw std::out_of_range("No access");
+
+    current = skipRemoved(current->next(0).load());
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator it(*this);
+    ++(*this);
+    return it;
+  }
+
+  // copy of the item, its value may be replaced concurrently
+  value_type operator*() const
+  {
+    if(current == nullptr)
+        throw std::out_of_range("No access");
+    return value_type(current->key, current->value.load()->mapped);
+  }
+
+  const key_type& key() const
+  {
+    if(current == nullptr)
+        throw std::out_of_range("No access");
+    return current->key;
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return current == other.current;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_CONCURRENTTREEMAP_H */
@@ -0,0 +1,280 @@
+#ifndef AISDI_MAPS_FROZENTREEMAP_H
+#define AISDI_MAPS_FROZENTREEMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace aisdi
+{
+
+// Immutable sorted map laid out in Eytzinger (BFS) order: node k has children 2k and 2k + 1.
+// Keys sit alone in one array for a cache-friendly search, items follow the same order in a parallel one.
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>>
+class FrozenTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+
+private:
+    std::vector<key_type> keys; //keys[0] is unused
+    std::vector<value_type> items; //items[k - 1] belongs to keys[k]
+    Compare compare;
+
+public:
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+
+  explicit FrozenTreeMap(const Compare& compare = Compare()) : keys(1), compare(compare)
+  {}
+
+  // [first, last) has to be sorted by key without duplicates
+  template <typename ForwardIterator>
+  FrozenTreeMap(ForwardIterator first, ForwardIterator last, const Compare& compare = Compare())
+    : compare(compare)
+  {
+    std::vector<const value_type*> sorted;
+    for(; first != last; ++first)
+        sorted.push_back(&*first);
+
+    std::vector<size_type> order(sorted.size() + 1);
+    size_type next = 0;
+    layout(1, order, next);
+
+    keys.reserve(sorted.size() + 1);
+    keys.emplace_back();
+    items.reserve(sorted.size());
+    for(size_type k = 1; k <= sorted.size(); ++k) {
+        keys.push_back(sorted[order[k]]->first);
+        items.push_back(*sorted[order[k]]);
+    }
+  }
+
+  bool isEmpty() const
+  {
+    return items.empty();
+  }
+
+  size_type getSize() const
+  {
+    return items.size();
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    size_type k = findIndex(key);
+    if(k == 0)
+        throw std::out_of_range("No such element");
+    return items[k - 1].second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    return ConstIterator(this, findIndex(key));
+  }
+
+  // first item with key not less than the given one
+  const_iterator lower_bound(const key_type& key) const
+  {
+    return ConstIterator(this, lowerBound(key));
+  }
+
+  bool operator==(const FrozenTreeMap& other) const
+  {
+    if(getSize() != other.getSize()) return false;
+
+    for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
+        size_type k = findIndex(it->first);
+        if(k == 0 || items[k - 1].second != it->second) return false;
+    }
+
+    return true;
+  }
+
+  bool operator!=(const FrozenTreeMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  const_iterator cbegin() const
+  {
+    size_type k = isEmpty() ? 0 : 1;
+    while(k != 0 && 2 * k <= getSize())
+        k = 2 * k;
+    return ConstIterator(this, k);
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this, 0);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    // in-order walk over the implicit tree hands out sorted positions
+    void layout(size_type k, std::vector<size_type>& order, size_type& next) {
+        if(k >= order.size()) return;
+        layout(2 * k, order, next);
+        order[k] = next++;
+        layout(2 * k + 1, order, next);
+    }
+
+    // climbs while k is a right child and then once more, 0 past the root
+    static size_type parentOfRightSpine(size_type k) {
+#if defined(__GNUC__)
+        return k >> __builtin_ffsll(~static_cast<unsigned long long>(k));
+#else
+        while(k & 1)
+            k >>= 1;
+        return k >> 1;
+#endif
+    }
+
+    static size_type parentOfLeftSpine(size_type k) {
+#if defined(__GNUC__)
+        return k >> __builtin_ffsll(static_cast<unsigned long long>(k));
+#else
+        while((k & 1) == 0)
+            k >>= 1;
+        return k >> 1;
+#endif
+    }
+
+    size_type lowerBound(const key_type& key) const {
+        const key_type *base = keys.data();
+        const size_type n = getSize();
+#if defined(__GNUC__)
+        //addresses past the end are formed as integers, a pointer there would be undefined
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(base);
+#endif
+
+        size_type k = 1;
+        while(k <= n) {
+#if defined(__GNUC__)
+            __builtin_prefetch(reinterpret_cast<const void*>(address + 16 * k * sizeof(key_type))); //four levels down
+#endif
+            k = 2 * k + compare(base[k], key);
+        }
+
+        return parentOfRightSpine(k);
+    }
+
+    size_type findIndex(const key_type& key) const {
+        size_type k = lowerBound(key);
+        if(k == 0 || compare(key, keys[k])) return 0;
+        return k;
+    }
+};
+
+template <typename KeyType, typename ValueType, typename Compare>
+class FrozenTreeMap<KeyType, ValueType, Compare>::ConstIterator
+{
+    friend class FrozenTreeMap;
+
+    const FrozenTreeMap *map;
+    std::size_t index; //0 at end
+
+    ConstIterator(const FrozenTreeMap *map, std::size_t index) : map(map), index(index)
+    {}
+
+public:
+  using reference = typename FrozenTreeMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename FrozenTreeMap::value_type;
+  using pointer = const typename FrozenTreeMap::value_type*;
+  using difference_type = std::ptrdiff_t;
+
+  explicit ConstIterator() : map(nullptr), index(0)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(map == nullptr || index == 0)
+        throw std::out_of_range("No access");
+
+    const std::size_t n = map->getSize();
+    if(2 * index + 1 <= n) {
+        index = 2 * index + 1;
+        while(2 * index <= n)
+            index = 2 * index;
+    } else index = FrozenTreeMap::parentOfRightSpine(index);
+
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator it(*this);
+    ++(*this);
+    return it;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(map == nullptr || map->isEmpty())
+        throw std::out_of_range("No access");
+
+    const std::size_t n = map->getSize();
+    std::size_t previous;
+    if(index == 0 || 2 * index <= n) {
+        previous = index == 0 ? 1 : 2 * index;
+        while(2 * previous + 1 <= n)
+            previous = 2 * previous + 1;
+    } else previous = FrozenTreeMap::parentOfLeftSpine(index);
+
+    if(previous == 0)
+        throw std::out_of_range("No access"); //begin
+    index = previous;
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator it(*this);
+    --(*this);
+    return it;
+  }
+
+  reference operator*() const
+  {
+    if(map == nullptr || index == 0)
+        throw std::out_of_range("No access");
+    return map->items[index - 1];
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return map == other.map && index == other.index;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_FROZENTREEMAP_H */
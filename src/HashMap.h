@@ -70,7 +70,6 @@ public:
 
     this->clear();
 
-    this->size = 0;
     ConstIterator it = other.cbegin();
     for(;it != other.cend(); ++it) {
         (*this)[it->first] = it->second;
@@ -171,6 +170,15 @@ public:
     return end();
   }
 
+  bool contains(const key_type& key) const
+  {
+    const std::list<value_type>& bucket = hashTable[std::hash<key_type>()(key) % BUCKETS_NUMBER];
+    for(const value_type& item : bucket) {
+        if(item.first == key) return true;
+    }
+    return false;
+  }
+
   void remove(const key_type& key)
   {
     ConstIterator it = find(key);
@@ -224,7 +232,7 @@ public:
 
   const_iterator cbegin() const
   {
-    if(isEmpty()) return ConstIterator(0, hashTable[0].begin(), hashTable);
+    if(isEmpty()) return cend();
     size_t i = 0;
     while(i < BUCKETS_NUMBER) {
         if(!hashTable[i].empty()) {
@@ -232,20 +240,13 @@ public:
         }
         ++i;
     }
-    return ConstIterator(0, hashTable[0].begin(), hashTable);
+    return cend();
   }
 
+  // past the end of the last bucket whatever it holds, so end() needs no scan and stays put
   const_iterator cend() const
   {
-    if(isEmpty()) return ConstIterator(0, hashTable[0].end(), hashTable);
-    int i = BUCKETS_NUMBER - 1;
-    while(i >= 0) {
-        if(!hashTable[i].empty()) {
-            return ConstIterator(i, hashTable[i].end(), hashTable);
-        }
-        --i;
-    }
-    return ConstIterator(0, hashTable[0].begin(), hashTable);
+    return ConstIterator(BUCKETS_NUMBER - 1, hashTable[BUCKETS_NUMBER - 1].end(), hashTable);
   }
 
   const_iterator begin() const
@@ -258,17 +259,13 @@ public:
     return cend();
   }
 
-private:
-    void clear() {
-        for(size_type i = 0; i < BUCKETS_NUMBER; ++i) {
-            if(!hashTable[i].empty()) {
-                size_type number = hashTable[i].size();
-                for(;number > 0; --number) {
-                    hashTable[i].pop_back();
-                }
-            }
-        }
+  void clear()
+  {
+    for(size_type i = 0; i < BUCKETS_NUMBER; ++i) {
+        hashTable[i].clear();
     }
+    size = 0;
+  }
 };
 
 template <typename KeyType, typename ValueType>
@@ -314,6 +311,8 @@ public:
 
             ++i;
         }
+        index = BUCKETS_NUMBER - 1;
+        it = hashTable[index].end();
     }
 
     return *this;
@@ -0,0 +1,158 @@
+#ifndef AISDI_MAPS_LATENCYHISTOGRAM_H
+#define AISDI_MAPS_LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace aisdi
+{
+
+// Cheapest timestamp available: the time stamp counter on x86, steady_clock elsewhere.
+// Assumes an invariant TSC; ticks are converted with a rate calibrated once against steady_clock.
+struct LatencyClock
+{
+  static std::uint64_t now()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  static double nanosecondsPerTick()
+  {
+    static const double rate = calibrate();
+    return rate;
+  }
+
+private:
+    static double calibrate() {
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t first = now();
+        while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {}
+        const std::uint64_t last = now();
+        const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return last > first ? elapsed / (last - first) : 1;
+    }
+};
+
+// Log-linear histogram after HdrHistogram: values below 2^precisionBits are counted exactly, every
+// higher power of two is split into 2^(precisionBits - 1) equal buckets, which bounds the relative
+// error by 2^-(precisionBits - 1) over the whole 64-bit range with a few thousand counters.
+class LatencyHistogram
+{
+public:
+  explicit LatencyHistogram(unsigned int precisionBits = 7)
+    : precisionBits(precisionBits), total(0), minimum(std::numeric_limits<std::uint64_t>::max()), maximum(0)
+  {
+    if(precisionBits < 1 || precisionBits > 16)
+        throw std::invalid_argument("Histogram precision must lie in [1, 16] bits");
+    counts.resize(indexOf(std::numeric_limits<std::uint64_t>::max()) + 1);
+  }
+
+  void record(std::uint64_t value, std::uint64_t count = 1)
+  {
+    if(count == 0)
+        return;
+    counts[indexOf(value)] += count;
+    total += count;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+  }
+
+  // records the ticks spent in operation
+  template <typename Operation>
+  void time(Operation&& operation)
+  {
+    const std::uint64_t start = LatencyClock::now();
+    operation();
+    record(LatencyClock::now() - start);
+  }
+
+  void merge(const LatencyHistogram& other)
+  {
+    if(other.precisionBits != precisionBits)
+        throw std::invalid_argument("Cannot merge histograms of different precision");
+    for(std::size_t i = 0; i < counts.size(); ++i)
+        counts[i] += other.counts[i];
+    total += other.total;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+  }
+
+  // highest value equivalent to the one below which percent of the recorded values fall
+  std::uint64_t percentile(double percent) const
+  {
+    if(total == 0)
+        return 0;
+    const double rank = std::max(1.0, std::min(100.0, percent) / 100 * total);
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if(seen >= rank)
+            return std::min(maximum, highestEquivalent(i));
+    }
+    return maximum;
+  }
+
+  std::uint64_t getCount() const
+  {
+    return total;
+  }
+
+  std::uint64_t min() const
+  {
+    return total == 0 ? 0 : minimum;
+  }
+
+  std::uint64_t max() const
+  {
+    return maximum;
+  }
+
+private:
+    unsigned int precisionBits;
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total;
+    std::uint64_t minimum;
+    std::uint64_t maximum;
+
+    static unsigned int log2(std::uint64_t value) {
+        unsigned int bits = 0;
+        while(value >>= 1)
+            ++bits;
+        return bits;
+    }
+
+    std::size_t indexOf(std::uint64_t value) const {
+        if(value < (std::uint64_t(1) << precisionBits))
+            return value;
+        const unsigned int shift = log2(value) - (precisionBits - 1);
+        return (std::size_t(shift) << (precisionBits - 1)) + (value >> shift);
+    }
+
+    std::uint64_t highestEquivalent(std::size_t index) const {
+        if(index < (std::size_t(1) << precisionBits))
+            return index;
+        const std::size_t half = std::size_t(1) << (precisionBits - 1);
+        const unsigned int shift = (index - half) / half;
+        const std::uint64_t sub = index - (std::size_t(shift) << (precisionBits - 1));
+        const std::uint64_t next = (sub + 1) << shift;
+        return next == 0 ? std::numeric_limits<std::uint64_t>::max() : next - 1;
+    }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_LATENCYHISTOGRAM_H */
@@ -0,0 +1,179 @@
+#ifndef AISDI_MAPS_MEMORYUSAGE_H
+#define AISDI_MAPS_MEMORYUSAGE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace aisdi
+{
+
+// Heap statistics kept by countedAllocate / countedFree. A program opts in by routing its global
+// operator new and delete through them; counting stays off until enabled, so timing runs pay one branch.
+// Bytes are malloc_usable_size, i.e. what the allocator actually reserved, and are only known on glibc.
+struct AllocationCounters
+{
+  std::atomic<bool> enabled;
+  std::atomic<std::uint64_t> allocations;
+  std::atomic<std::uint64_t> frees;
+  std::atomic<std::int64_t> liveBytes;
+  std::atomic<std::int64_t> peakBytes;
+};
+
+inline AllocationCounters& allocationCounters()
+{
+  static AllocationCounters counters{ { false }, { 0 }, { 0 }, { 0 }, { 0 } };
+  return counters;
+}
+
+inline std::size_t allocatedSize(void* pointer)
+{
+#if defined(__GLIBC__)
+  return malloc_usable_size(pointer);
+#else
+  (void)pointer;
+  return 0;
+#endif
+}
+
+inline void* counted(void* pointer)
+{
+  AllocationCounters& counters = allocationCounters();
+  if(pointer != nullptr && counters.enabled.load(std::memory_order_relaxed)) {
+      const std::int64_t bytes = allocatedSize(pointer);
+      counters.allocations.fetch_add(1, std::memory_order_relaxed);
+      const std::int64_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+      std::int64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+      while(live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+  }
+  return pointer;
+}
+
+inline void* countedAllocate(std::size_t size)
+{
+  return counted(std::malloc(size == 0 ? 1 : size));
+}
+
+inline void* countedAllocate(std::size_t size, std::size_t alignment)
+{
+  void* pointer = nullptr;
+  if(posix_memalign(&pointer, std::max(alignment, sizeof(void*)), size == 0 ? 1 : size) != 0)
+    return nullptr;
+  return counted(pointer);
+}
+
+// gcc pairs free() with the operator new countedAllocate backs once both are inlined
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+inline void countedFree(void* pointer)
+{
+  if(pointer == nullptr)
+    return;
+
+  AllocationCounters& counters = allocationCounters();
+  if(counters.enabled.load(std::memory_order_relaxed)) {
+      counters.frees.fetch_add(1, std::memory_order_relaxed);
+      counters.liveBytes.fetch_sub(allocatedSize(pointer), std::memory_order_relaxed);
+  }
+  std::free(pointer);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+struct AllocationSnapshot
+{
+  std::uint64_t allocations;
+  std::uint64_t frees;
+  std::int64_t liveBytes;
+  std::int64_t peakBytes;
+
+  static AllocationSnapshot take()
+  {
+    const AllocationCounters& counters = allocationCounters();
+    return { counters.allocations.load(), counters.frees.load(), counters.liveBytes.load(), counters.peakBytes.load() };
+  }
+
+  // restarts the peak from what is live now
+  static void resetPeak()
+  {
+    AllocationCounters& counters = allocationCounters();
+    counters.peakBytes.store(counters.liveBytes.load());
+  }
+};
+
+// Process memory as seen by the kernel and by malloc; values are 0 where the platform does not expose them.
+struct ProcessMemory
+{
+  static std::uint64_t residentBytes()
+  {
+    return procField("/proc/self/status", "VmRSS:");
+  }
+
+  static std::uint64_t peakResidentBytes()
+  {
+    return procField("/proc/self/status", "VmHWM:");
+  }
+
+  // memory the system could hand out without swapping
+  static std::uint64_t availableBytes()
+  {
+    return procField("/proc/meminfo", "MemAvailable:");
+  }
+
+  // lets peakResidentBytes() start over from the current RSS, false if the kernel refuses
+  static bool resetPeakResident()
+  {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    return static_cast<bool>(clearRefs << "5" << std::flush);
+  }
+
+  // bytes malloc holds from the system: its heap plus blocks mapped on their own
+  static std::uint64_t heapBytes()
+  {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return info.arena + info.hblkhd;
+#else
+    return 0;
+#endif
+  }
+
+  // hands free heap pages back, so fragmentation of one measurement does not leak into the next
+  static void trimHeap()
+  {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+  }
+
+private:
+    static std::uint64_t procField(const char* path, const std::string& field) {
+        std::ifstream status(path);
+        std::string name;
+        while(status >> name) {
+            if(name == field) {
+                std::uint64_t kilobytes = 0;
+                status >> kilobytes;
+                return kilobytes * 1024;
+            }
+            status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+        return 0;
+    }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_MEMORYUSAGE_H */
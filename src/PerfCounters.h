@@ -0,0 +1,257 @@
+#ifndef AISDI_MAPS_PERFCOUNTERS_H
+#define AISDI_MAPS_PERFCOUNTERS_H
+
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace aisdi
+{
+
+enum class PerfEvent
+{
+  Cycles,
+  Instructions,
+  L1dMisses,
+  LlcMisses,
+  DtlbMisses,
+  BranchMisses
+};
+
+// Counts of every PerfEvent; NaN marks an event the machine or the kernel would not count.
+struct PerfSample
+{
+  static const std::size_t size = 6;
+
+  std::array<double, size> values;
+
+  PerfSample()
+  {
+    values.fill(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  double& operator[](PerfEvent event)
+  {
+    return values[static_cast<std::size_t>(event)];
+  }
+
+  double operator[](PerfEvent event) const
+  {
+    return values[static_cast<std::size_t>(event)];
+  }
+
+  bool empty() const
+  {
+    for(double value : values)
+        if(!std::isnan(value))
+            return false;
+    return true;
+  }
+
+  static const char* name(std::size_t index)
+  {
+    static const char* const names[size] = { "cycles", "instructions", "L1d-misses", "LLC-misses", "dTLB-misses",
+                                             "branch-misses" };
+    return names[index];
+  }
+};
+
+// Hardware counters of the calling process via perf_event_open, user space only, inherited by
+// threads started while they are open. Every event is opened on its own, so a missing one only
+// blanks its column; counts are scaled by time enabled / time running when the PMU multiplexes.
+// Nothing is opened until open() is called; start() and stop() are no-ops while closed.
+class PerfCounters
+{
+public:
+  static PerfCounters& instance()
+  {
+    static PerfCounters counters;
+    return counters;
+  }
+
+  // true if at least one event could be opened, otherwise getError() tells why
+  bool open()
+  {
+#if defined(__linux__)
+    if(isOpen)
+        return true;
+    for(std::size_t i = 0; i < PerfSample::size; ++i) {
+        descriptors[i] = openEvent(static_cast<PerfEvent>(i));
+        if(descriptors[i] < 0 && error.empty())
+            error = std::strerror(errno);
+        isOpen = isOpen || descriptors[i] >= 0;
+    }
+    if(isOpen)
+        error.clear();
+#else
+    error = "perf_event_open is Linux only";
+#endif
+    return isOpen;
+  }
+
+  bool available() const
+  {
+    return isOpen;
+  }
+
+  const std::string& getError() const
+  {
+    return error;
+  }
+
+  void start()
+  {
+    if(isOpen)
+        control(enableRequest);
+  }
+
+  void stop()
+  {
+    if(isOpen)
+        control(disableRequest);
+  }
+
+  void reset()
+  {
+    for(std::size_t i = 0; i < PerfSample::size; ++i)
+        readRaw(i, baseline[i]);
+  }
+
+  // counts since the last reset()
+  PerfSample read() const
+  {
+    PerfSample sample;
+    for(std::size_t i = 0; i < PerfSample::size; ++i) {
+        RawCount raw;
+        if(!readRaw(i, raw))
+            continue;
+        const double value = raw.value - baseline[i].value;
+        const double enabled = raw.enabled - baseline[i].enabled;
+        const double running = raw.running - baseline[i].running;
+        sample.values[i] = running == 0 ? 0 : value * enabled / running;
+    }
+    return sample;
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters()
+  {
+#if defined(__linux__)
+    for(int descriptor : descriptors)
+        if(descriptor >= 0)
+            close(descriptor);
+#endif
+  }
+
+private:
+#if defined(__linux__)
+    static const unsigned long enableRequest = PERF_EVENT_IOC_ENABLE;
+    static const unsigned long disableRequest = PERF_EVENT_IOC_DISABLE;
+#else
+    static const unsigned long enableRequest = 0;
+    static const unsigned long disableRequest = 0;
+#endif
+
+    // layout read() gets for PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+    struct RawCount
+    {
+      std::uint64_t value = 0;
+      std::uint64_t enabled = 0;
+      std::uint64_t running = 0;
+    };
+
+    std::array<int, PerfSample::size> descriptors;
+    std::array<RawCount, PerfSample::size> baseline;
+    bool isOpen;
+    std::string error;
+
+    PerfCounters() : isOpen(false) {
+        descriptors.fill(-1);
+    }
+
+    bool readRaw(std::size_t index, RawCount& raw) const {
+#if defined(__linux__)
+        std::uint64_t data[3];
+        if(descriptors[index] < 0 || ::read(descriptors[index], data, sizeof(data)) != sizeof(data))
+            return false;
+        raw.value = data[0];
+        raw.enabled = data[1];
+        raw.running = data[2];
+        return true;
+#else
+        (void)index;
+        (void)raw;
+        return false;
+#endif
+    }
+
+    void control(unsigned long request) {
+#if defined(__linux__)
+        for(int descriptor : descriptors)
+            if(descriptor >= 0)
+                ioctl(descriptor, request, 0);
+#else
+        (void)request;
+#endif
+    }
+
+#if defined(__linux__)
+    static int openEvent(PerfEvent event) {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.disabled = 1;
+        attributes.inherit = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const std::uint64_t readMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch(event) {
+        case PerfEvent::Cycles:
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfEvent::Instructions:
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfEvent::L1dMisses:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_L1D | readMiss;
+            break;
+        case PerfEvent::LlcMisses:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_LL | readMiss;
+            break;
+        case PerfEvent::DtlbMisses:
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = PERF_COUNT_HW_CACHE_DTLB | readMiss;
+            break;
+        case PerfEvent::BranchMisses:
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        }
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+#endif
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_PERFCOUNTERS_H */
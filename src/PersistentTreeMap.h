@@ -0,0 +1,366 @@
+#ifndef AISDI_MAPS_PERSISTENTTREEMAP_H
+#define AISDI_MAPS_PERSISTENTTREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace aisdi
+{
+
+// Immutable AVL nodes shared between versions, updates copy only the root-to-leaf path.
+// A single writer may update the map while readers take snapshot() from other threads.
+template <typename KeyType, typename ValueType>
+class PersistentTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    NodePtr root;
+
+public:
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+
+  PersistentTreeMap()
+  {}
+
+  PersistentTreeMap(std::initializer_list<value_type> list)
+  {
+    for(auto&& entry : list) {
+        insert(entry.first, entry.second);
+    }
+  }
+
+  PersistentTreeMap(const PersistentTreeMap& other) = default;
+  PersistentTreeMap(PersistentTreeMap&& other) = default;
+  PersistentTreeMap& operator=(const PersistentTreeMap& other) = default;
+  PersistentTreeMap& operator=(PersistentTreeMap&& other) = default;
+
+  PersistentTreeMap snapshot() const
+  {
+    PersistentTreeMap version;
+    version.root = std::atomic_load(&root);
+    return version;
+  }
+
+  bool isEmpty() const
+  {
+    return root == nullptr;
+  }
+
+  void insert(const key_type& key, const mapped_type& value)
+  {
+    std::atomic_store(&root, insert(root, key, value));
+  }
+
+  void remove(const key_type& key)
+  {
+    if(findNode(key) == nullptr)
+        throw std::out_of_range("No such element");
+    std::atomic_store(&root, remove(root, key));
+  }
+
+  void remove(const const_iterator& it)
+  {
+    remove(it->first);
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    const Node *tmp = findNode(key);
+    if(tmp == nullptr)
+        throw std::out_of_range("No such element");
+    return tmp->value.second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    ConstIterator it(root);
+    const Node *current = root.get();
+
+    while(current != nullptr) {
+        it.path.push_back(current);
+        if(key < current->value.first)
+            current = current->left.get();
+        else if(current->value.first < key)
+            current = current->right.get();
+        else return it;
+    }
+
+    return cend();
+  }
+
+  size_type getSize() const
+  {
+    return count(root.get());
+  }
+
+  bool operator==(const PersistentTreeMap& other) const
+  {
+    if(root == other.root) return true;
+    if(getSize() != other.getSize()) return false;
+
+    for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
+        const Node *tmp = findNode(it->first);
+        if(tmp == nullptr || tmp->value.second != it->second) return false;
+    }
+
+    return true;
+  }
+
+  bool operator!=(const PersistentTreeMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  const_iterator cbegin() const
+  {
+    ConstIterator it(root);
+    for(const Node *current = root.get(); current != nullptr; current = current->left.get())
+        it.path.push_back(current);
+    return it;
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(root);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    const Node* findNode(const key_type& key) const {
+        const Node *current = root.get();
+
+        while(current != nullptr) {
+            if(key < current->value.first)
+                current = current->left.get();
+            else if(current->value.first < key)
+                current = current->right.get();
+            else break;
+        }
+
+        return current;
+    }
+
+    static int height(const Node* node) {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    static size_type count(const Node* node) {
+        return node == nullptr ? 0 : node->count;
+    }
+
+    static NodePtr make(const NodePtr& left, const value_type& value, const NodePtr& right) {
+        return std::make_shared<const Node>(left, value, right);
+    }
+
+    static NodePtr balance(const NodePtr& left, const value_type& value, const NodePtr& right) {
+        if(height(left.get()) > height(right.get()) + 1) {
+            if(height(left->left.get()) >= height(left->right.get()))
+                return make(left->left, left->value, make(left->right, value, right));
+
+            const NodePtr& middle = left->right;
+            return make(make(left->left, left->value, middle->left), middle->value,
+                        make(middle->right, value, right));
+        }
+
+        if(height(right.get()) > height(left.get()) + 1) {
+            if(height(right->right.get()) >= height(right->left.get()))
+                return make(make(left, value, right->left), right->value, right->right);
+
+            const NodePtr& middle = right->left;
+            return make(make(left, value, middle->left), middle->value,
+                        make(middle->right, right->value, right->right));
+        }
+
+        return make(left, value, right);
+    }
+
+    static NodePtr insert(const NodePtr& node, const key_type& key, const mapped_type& value) {
+        if(node == nullptr)
+            return make(nullptr, value_type(key, value), nullptr);
+
+        if(key < node->value.first)
+            return balance(insert(node->left, key, value), node->value, node->right);
+        if(node->value.first < key)
+            return balance(node->left, node->value, insert(node->right, key, value));
+        return make(node->left, value_type(key, value), node->right);
+    }
+
+    // key has to be present
+    static NodePtr remove(const NodePtr& node, const key_type& key) {
+        if(key < node->value.first)
+            return balance(remove(node->left, key), node->value, node->right);
+        if(node->value.first < key)
+            return balance(node->left, node->value, remove(node->right, key));
+
+        if(node->left == nullptr) return node->right;
+        if(node->right == nullptr) return node->left;
+
+        NodePtr successor;
+        NodePtr rest = removeFirst(node->right, successor);
+        return balance(node->left, successor->value, rest);
+    }
+
+    static NodePtr removeFirst(const NodePtr& node, NodePtr& first) {
+        if(node->left == nullptr) {
+            first = node;
+            return node->right;
+        }
+
+        return balance(removeFirst(node->left, first), node->value, node->right);
+    }
+};
+
+template <typename KeyType, typename ValueType>
+struct PersistentTreeMap<KeyType, ValueType>::Node
+{
+    NodePtr left, right;
+    int height;
+    size_type count;
+    value_type value;
+
+    Node(const NodePtr& left, const value_type& value, const NodePtr& right)
+        : left(left), right(right), value(value) {
+        this->height = 1 + std::max(PersistentTreeMap::height(left.get()),
+                                    PersistentTreeMap::height(right.get()));
+        this->count = 1 + PersistentTreeMap::count(left.get()) + PersistentTreeMap::count(right.get());
+    }
+};
+
+// Keeps its version alive, so it stays valid after the map is updated.
+template <typename KeyType, typename ValueType>
+class PersistentTreeMap<KeyType, ValueType>::ConstIterator
+{
+    friend class PersistentTreeMap;
+
+    NodePtr root;
+    std::vector<const Node*> path; //empty at end
+
+public:
+  using reference = typename PersistentTreeMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename PersistentTreeMap::value_type;
+  using pointer = const typename PersistentTreeMap::value_type*;
+  using difference_type = std::ptrdiff_t;
+
+  explicit ConstIterator()
+  {}
+
+  explicit ConstIterator(const NodePtr& root) : root(root)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(path.empty())
+        throw std::out_of_range("No access");
+
+    const Node *current = path.back();
+    if(current->right != nullptr) {
+        for(current = current->right.get(); current != nullptr; current = current->left.get())
+            path.push_back(current);
+        return *this;
+    }
+
+    path.pop_back();
+    while(!path.empty() && path.back()->right.get() == current) {
+        current = path.back();
+        path.pop_back();
+    }
+
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator it(*this);
+    ++(*this);
+    return it;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(path.empty()) {
+        if(root == nullptr)
+            throw std::out_of_range("No access");
+        for(const Node *current = root.get(); current != nullptr; current = current->right.get())
+            path.push_back(current);
+        return *this;
+    }
+
+    const Node *current = path.back();
+    if(current->left != nullptr) {
+        for(current = current->left.get(); current != nullptr; current = current->right.get())
+            path.push_back(current);
+        return *this;
+    }
+
+    std::size_t i = path.size() - 1;
+    while(i > 0 && path[i - 1]->left.get() == path[i])
+        --i;
+    if(i == 0)
+        throw std::out_of_range("No access"); //begin
+
+    path.resize(i);
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator it(*this);
+    --(*this);
+    return it;
+  }
+
+  reference operator*() const
+  {
+    if(path.empty())
+        throw std::out_of_range("No access");
+    return path.back()->value;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    const Node *current = path.empty() ? nullptr : path.back();
+    const Node *otherCurrent = other.path.empty() ? nullptr : other.path.back();
+    return root == other.root && current == otherCurrent;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_PERSISTENTTREEMAP_H */
@@ -0,0 +1,1082 @@
+#ifndef AISDI_MAPS_RADIXTREEMAP_H
+#define AISDI_MAPS_RADIXTREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace aisdi
+{
+
+// Turns keys into byte strings ordered like the keys themselves, held in Bytes
+// offering data() and size(). No encoded key may be a prefix of another one.
+template <typename KeyType, typename Enable = void>
+struct RadixKey;
+
+// big-endian, sign bit flipped so negative numbers go first
+template <typename KeyType>
+struct RadixKey<KeyType, typename std::enable_if<std::is_integral<KeyType>::value>::type>
+{
+    // fixed width, so encoding a key never allocates
+    class Bytes
+    {
+        char bytes[sizeof(KeyType)];
+
+    public:
+        const char* data() const {
+            return bytes;
+        }
+
+        char* data() {
+            return bytes;
+        }
+
+        std::size_t size() const {
+            return sizeof(KeyType);
+        }
+    };
+
+    static void encode(const KeyType& key, Bytes& bytes) {
+        using Unsigned = typename std::make_unsigned<KeyType>::type;
+
+        Unsigned value = static_cast<Unsigned>(key);
+        if(std::is_signed<KeyType>::value)
+            value ^= Unsigned(1) << (8 * sizeof(KeyType) - 1);
+
+        for(std::size_t i = sizeof(KeyType); i > 0; --i, value >>= 8)
+            bytes.data()[i - 1] = static_cast<char>(value & 0xFF);
+    }
+};
+
+// zero bytes are escaped as 00 FF and the key ends with 00 00
+template <>
+struct RadixKey<std::string>
+{
+    using Bytes = std::string;
+
+    static void encode(const std::string& key, std::string& bytes) {
+        encodePrefix(key, bytes);
+        bytes.push_back('\0');
+        bytes.push_back('\0');
+    }
+
+    // encoded keys starting with key begin with these bytes
+    static void encodePrefix(const std::string& key, std::string& bytes) {
+        bytes.clear();
+        bytes.reserve(key.size() + 2);
+        for(char c : key) {
+            bytes.push_back(c);
+            if(c == '\0')
+                bytes.push_back('\xFF');
+        }
+    }
+};
+
+// Adaptive radix tree: inner nodes grow from 4 to 16, 48 and 256 children as needed,
+// single-child chains are compressed into node prefixes and a key is kept in a lone leaf
+// until another key shares its path. Lookups cost O(key length) independent of size.
+// Iterators stay valid until the map is modified.
+template <typename KeyType, typename ValueType>
+class RadixTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+private:
+    using Traits = RadixKey<key_type>;
+    using Bytes = typename Traits::Bytes;
+    using Prefix = std::string;
+
+    enum NodeType : std::uint8_t { LeafNode, Node4, Node16, Node48, Node256 };
+
+    struct Node;
+    struct Leaf;
+    struct Inner;
+    struct Inner4;
+    struct Inner16;
+    struct Inner48;
+    struct Inner256;
+    using Path = std::vector<std::pair<const Inner*, int>>; //inner nodes with byte of the child taken
+
+    Node *root;
+    size_type size;
+
+public:
+  class ConstIterator;
+  class Iterator;
+  using iterator = Iterator;
+  using const_iterator = ConstIterator;
+
+  RadixTreeMap() : root(nullptr), size(0)
+  {}
+
+  RadixTreeMap(std::initializer_list<value_type> list) : RadixTreeMap()
+  {
+    for(auto&& entry : list) {
+        (*this)[entry.first] = entry.second;
+    }
+  }
+
+  RadixTreeMap(const RadixTreeMap& other) : RadixTreeMap()
+  {
+    for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
+        (*this)[it->first] = it->second;
+    }
+  }
+
+  RadixTreeMap(RadixTreeMap&& other) : root(other.root), size(other.size)
+  {
+    other.root = nullptr;
+    other.size = 0;
+  }
+
+  ~RadixTreeMap()
+  {
+    destroy(root);
+  }
+
+  RadixTreeMap& operator=(const RadixTreeMap& other)
+  {
+    if(this == &other) return *this;
+
+    RadixTreeMap copy(other);
+    std::swap(root, copy.root);
+    std::swap(size, copy.size);
+    return *this;
+  }
+
+  RadixTreeMap& operator=(RadixTreeMap&& other)
+  {
+    if(this == &other) return *this;
+
+    destroy(root);
+    root = other.root;
+    size = other.size;
+    other.root = nullptr;
+    other.size = 0;
+    return *this;
+  }
+
+  bool isEmpty() const
+  {
+    return size == 0;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    Bytes bytes;
+    Traits::encode(key, bytes);
+    return insertLeaf(root, bytes, 0, key)->value.second;
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    const Leaf *tmp = findLeaf(key);
+    if(tmp == nullptr)
+        throw std::out_of_range("No such element");
+    return tmp->value.second;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    const Leaf *tmp = findLeaf(key);
+    if(tmp == nullptr)
+        throw std::out_of_range("No such element");
+    return const_cast<Leaf*>(tmp)->value.second;
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    Bytes bytes;
+    Traits::encode(key, bytes);
+
+    ConstIterator it = seek(bytes, KeyBefore{ key });
+    if(it.leaf != nullptr && it.leaf->value.first != key) return cend();
+    return it;
+  }
+
+  iterator find(const key_type& key)
+  {
+    return Iterator(static_cast<const RadixTreeMap*>(this)->find(key));
+  }
+
+  // first item with key not less than the given one
+  const_iterator lower_bound(const key_type& key) const
+  {
+    Bytes bytes;
+    Traits::encode(key, bytes);
+    return seek(bytes, KeyBefore{ key });
+  }
+
+  iterator lower_bound(const key_type& key)
+  {
+    return Iterator(static_cast<const RadixTreeMap*>(this)->lower_bound(key));
+  }
+
+  // items whose keys start with prefix, for key types able to encode prefixes
+  std::pair<const_iterator, const_iterator> prefix_range(const key_type& prefix) const
+  {
+    Bytes bytes;
+    Traits::encodePrefix(prefix, bytes);
+    ConstIterator first = seek(bytes, BytesBefore{ bytes });
+
+    while(!bytes.empty() && bytes.back() == '\xFF')
+        bytes.pop_back();
+    if(bytes.empty()) return std::make_pair(first, cend());
+
+    bytes.back() = static_cast<char>(static_cast<std::uint8_t>(bytes.back()) + 1);
+    return std::make_pair(first, seek(bytes, BytesBefore{ bytes }));
+  }
+
+  void remove(const key_type& key)
+  {
+    Bytes bytes;
+    Traits::encode(key, bytes);
+    if(!removeLeaf(root, bytes, 0, key))
+        throw std::out_of_range("No such element");
+  }
+
+  void remove(const const_iterator& it)
+  {
+    if(it.leaf == nullptr)
+        throw std::out_of_range("No such element");
+    Bytes bytes;
+    Traits::encode(it.leaf->value.first, bytes);
+    removeLeaf(root, bytes, 0, it.leaf->value.first);
+  }
+
+  size_type getSize() const
+  {
+    return size;
+  }
+
+  bool operator==(const RadixTreeMap& other) const
+  {
+    if(size != other.size) return false;
+
+    for(ConstIterator it = cbegin(), otherIt = other.cbegin(); it != cend(); ++it, ++otherIt) {
+        if(it->first != otherIt->first || it->second != otherIt->second) return false;
+    }
+
+    return true;
+  }
+
+  bool operator!=(const RadixTreeMap& other) const
+  {
+    return !(*this == other);
+  }
+
+  iterator begin()
+  {
+    return Iterator(cbegin());
+  }
+
+  iterator end()
+  {
+    return Iterator(cend());
+  }
+
+  const_iterator cbegin() const
+  {
+    ConstIterator it(this);
+    if(root != nullptr)
+        it.leaf = descendFirst(root, it.path);
+    return it;
+  }
+
+  const_iterator cend() const
+  {
+    return ConstIterator(this);
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    template <typename Encoded>
+    static std::uint8_t byteAt(const Encoded& bytes, size_type depth) {
+        return static_cast<std::uint8_t>(bytes.data()[depth]);
+    }
+
+    // orders the bytes from depth on against prefix like std::string::compare
+    template <typename Encoded>
+    static int compareAt(const Encoded& bytes, size_type depth, const Prefix& prefix) {
+        const size_type available = bytes.size() - depth;
+        const int order = std::memcmp(bytes.data() + depth, prefix.data(), std::min(available, prefix.size()));
+        if(order != 0) return order;
+        return available < prefix.size() ? -1 : 0;
+    }
+
+    // leaves seek() steps past: ordered by key when looking up a whole key...
+    struct KeyBefore
+    {
+        const key_type& key;
+
+        bool operator()(const Leaf* leaf) const {
+            return leaf->value.first < key;
+        }
+    };
+
+    // ...and by encoded key when looking up a prefix
+    struct BytesBefore
+    {
+        const Bytes& bytes;
+
+        bool operator()(const Leaf* leaf) const {
+            Bytes found;
+            Traits::encode(leaf->value.first, found);
+            return found < bytes;
+        }
+    };
+
+    // prefixes are skipped on the way down, the full key kept in the leaf settles the match
+    const Leaf* findLeaf(const key_type& key) const {
+        Bytes bytes;
+        Traits::encode(key, bytes);
+
+        const Node *node = root;
+        size_type depth = 0;
+        while(node != nullptr) {
+            if(node->type == LeafNode) {
+                const Leaf *leaf = static_cast<const Leaf*>(node);
+                return leaf->value.first == key ? leaf : nullptr;
+            }
+
+            const Inner *inner = static_cast<const Inner*>(node);
+            depth += inner->prefix.size();
+            if(depth >= bytes.size()) return nullptr;
+
+            Node* const *child = findChild(inner, byteAt(bytes, depth++));
+            node = child == nullptr ? nullptr : *child;
+        }
+
+        return nullptr;
+    }
+
+    Leaf* insertLeaf(Node*& ref, const Bytes& bytes, size_type depth, const key_type& key) {
+        if(ref == nullptr) {
+            Leaf *created = new Leaf(key);
+            ref = created;
+            ++size;
+            return created;
+        }
+
+        if(ref->type == LeafNode) {
+            Leaf *leaf = static_cast<Leaf*>(ref);
+            if(leaf->value.first == key) return leaf;
+
+            // neither key encodes to a prefix of the other, so they differ before either ends
+            Bytes existing;
+            Traits::encode(leaf->value.first, existing);
+            size_type common = depth;
+            while(byteAt(existing, common) == byteAt(bytes, common))
+                ++common;
+
+            Inner *node = new Inner4(Prefix(bytes.data() + depth, common - depth));
+            Leaf *created = new Leaf(key);
+            addChild(ref, node, byteAt(existing, common), leaf);
+            addChild(ref, node, byteAt(bytes, common), created);
+            ref = node;
+            ++size;
+            return created;
+        }
+
+        Inner *inner = static_cast<Inner*>(ref);
+        size_type matched = 0;
+        while(matched < inner->prefix.size() && depth + matched < bytes.size()
+              && static_cast<std::uint8_t>(inner->prefix[matched]) == byteAt(bytes, depth + matched))
+            ++matched;
+
+        if(matched < inner->prefix.size()) {
+            Inner *node = new Inner4(inner->prefix.substr(0, matched));
+            const std::uint8_t byte = static_cast<std::uint8_t>(inner->prefix[matched]);
+            inner->prefix.erase(0, matched + 1);
+
+            Leaf *created = new Leaf(key);
+            addChild(ref, node, byte, inner);
+            addChild(ref, node, byteAt(bytes, depth + matched), created);
+            ref = node;
+            ++size;
+            return created;
+        }
+
+        depth += matched;
+        Node **child = findChild(inner, byteAt(bytes, depth));
+        if(child != nullptr)
+            return insertLeaf(*child, bytes, depth + 1, key);
+
+        Leaf *created = new Leaf(key);
+        addChild(ref, inner, byteAt(bytes, depth), created);
+        ++size;
+        return created;
+    }
+
+    bool removeLeaf(Node*& ref, const Bytes& bytes, size_type depth, const key_type& key) {
+        if(ref == nullptr) return false;
+
+        if(ref->type == LeafNode) {
+            if(static_cast<Leaf*>(ref)->value.first != key) return false;
+            destroy(ref);
+            ref = nullptr;
+            --size;
+            return true;
+        }
+
+        Inner *inner = static_cast<Inner*>(ref);
+        depth += inner->prefix.size();
+        if(depth >= bytes.size()) return false;
+
+        const std::uint8_t byte = byteAt(bytes, depth);
+        Node **child = findChild(inner, byte);
+        if(child == nullptr) return false;
+
+        if((*child)->type != LeafNode)
+            return removeLeaf(*child, bytes, depth + 1, key);
+        if(static_cast<Leaf*>(*child)->value.first != key) return false;
+
+        destroy(*child);
+        removeChild(ref, inner, byte);
+        --size;
+        return true;
+    }
+
+    // first leaf not before the target, which before tells apart from the bytes alone
+    template <typename Before>
+    ConstIterator seek(const Bytes& bytes, Before before) const {
+        ConstIterator it(this);
+        const Node *node = root;
+        size_type depth = 0;
+
+        while(node != nullptr) {
+            if(node->type == LeafNode) {
+                it.leaf = static_cast<const Leaf*>(node);
+                if(before(it.leaf))
+                    it.leaf = advance(it.path);
+                return it;
+            }
+
+            const Inner *inner = static_cast<const Inner*>(node);
+            const int order = compareAt(bytes, depth, inner->prefix);
+            if(order < 0) {
+                it.leaf = descendFirst(node, it.path);
+                return it;
+            }
+            if(order > 0) {
+                it.leaf = advance(it.path);
+                return it;
+            }
+
+            depth += inner->prefix.size();
+            if(depth >= bytes.size()) {
+                it.leaf = descendFirst(node, it.path);
+                return it;
+            }
+
+            const int byte = byteAt(bytes, depth++);
+            const Node *child = nullptr;
+            const int taken = nextChild(inner, byte, child);
+            if(taken < 0) {
+                it.leaf = advance(it.path);
+                return it;
+            }
+
+            it.path.emplace_back(inner, taken);
+            if(taken > byte) {
+                it.leaf = descendFirst(child, it.path);
+                return it;
+            }
+            node = child;
+        }
+
+        return it;
+    }
+
+    static const Leaf* descendFirst(const Node* node, Path& path) {
+        while(node->type != LeafNode) {
+            const Inner *inner = static_cast<const Inner*>(node);
+            path.emplace_back(inner, nextChild(inner, 0, node));
+        }
+        return static_cast<const Leaf*>(node);
+    }
+
+    static const Leaf* descendLast(const Node* node, Path& path) {
+        while(node->type != LeafNode) {
+            const Inner *inner = static_cast<const Inner*>(node);
+            path.emplace_back(inner, previousChild(inner, 255, node));
+        }
+        return static_cast<const Leaf*>(node);
+    }
+
+    // leaf following the subtree path ends in, nullptr past the last one
+    static const Leaf* advance(Path& path) {
+        while(!path.empty()) {
+            const Inner *inner = path.back().first;
+            const int byte = path.back().second;
+            path.pop_back();
+
+            const Node *child = nullptr;
+            const int taken = nextChild(inner, byte + 1, child);
+            if(taken >= 0) {
+                path.emplace_back(inner, taken);
+                return descendFirst(child, path);
+            }
+        }
+        return nullptr;
+    }
+
+    static const Leaf* retreat(Path& path) {
+        while(!path.empty()) {
+            const Inner *inner = path.back().first;
+            const int byte = path.back().second;
+            path.pop_back();
+
+            const Node *child = nullptr;
+            const int taken = previousChild(inner, byte - 1, child);
+            if(taken >= 0) {
+                path.emplace_back(inner, taken);
+                return descendLast(child, path);
+            }
+        }
+        return nullptr;
+    }
+
+    static Node** findChild(const Inner* node, std::uint8_t byte) {
+        switch(node->type) {
+            case Node4: {
+                const Inner4 *inner = static_cast<const Inner4*>(node);
+                for(int i = 0; i < inner->count; ++i)
+                    if(inner->keys[i] == byte) return const_cast<Node**>(&inner->children[i]);
+                return nullptr;
+            }
+            case Node16: {
+                const Inner16 *inner = static_cast<const Inner16*>(node);
+#if defined(__SSE2__)
+                const __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inner->keys));
+                const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), keys))
+                                 & ((1 << inner->count) - 1);
+                if(mask == 0) return nullptr;
+                return const_cast<Node**>(&inner->children[__builtin_ctz(mask)]);
+#else
+                for(int i = 0; i < inner->count; ++i)
+                    if(inner->keys[i] == byte) return const_cast<Node**>(&inner->children[i]);
+                return nullptr;
+#endif
+            }
+            case Node48: {
+                const Inner48 *inner = static_cast<const Inner48*>(node);
+                if(inner->index[byte] == 0) return nullptr;
+                return const_cast<Node**>(&inner->children[inner->index[byte] - 1]);
+            }
+            default: {
+                const Inner256 *inner = static_cast<const Inner256*>(node);
+                if(inner->children[byte] == nullptr) return nullptr;
+                return const_cast<Node**>(&inner->children[byte]);
+            }
+        }
+    }
+
+    // smallest byte not below from having a child, -1 when there is none
+    static int nextChild(const Inner* node, int from, const Node*& child) {
+        switch(node->type) {
+            case Node4:
+            case Node16: {
+                const std::uint8_t *keys = node->type == Node4 ? static_cast<const Inner4*>(node)->keys
+                                                               : static_cast<const Inner16*>(node)->keys;
+                Node* const *children = node->type == Node4 ? static_cast<const Inner4*>(node)->children
+                                                            : static_cast<const Inner16*>(node)->children;
+                for(int i = 0; i < node->count; ++i) {
+                    if(keys[i] >= from) {
+                        child = children[i];
+                        return keys[i];
+                    }
+                }
+                return -1;
+            }
+            case Node48: {
+                const Inner48 *inner = static_cast<const Inner48*>(node);
+                for(int byte = from; byte < 256; ++byte) {
+                    if(inner->index[byte] != 0) {
+                        child = inner->children[inner->index[byte] - 1];
+                        return byte;
+                    }
+                }
+                return -1;
+            }
+            default: {
+                const Inner256 *inner = static_cast<const Inner256*>(node);
+                for(int byte = from; byte < 256; ++byte) {
+                    if(inner->children[byte] != nullptr) {
+                        child = inner->children[byte];
+                        return byte;
+                    }
+                }
+                return -1;
+            }
+        }
+    }
+
+    // largest byte not above from having a child, -1 when there is none
+    static int previousChild(const Inner* node, int from, const Node*& child) {
+        switch(node->type) {
+            case Node4:
+            case Node16: {
+                const std::uint8_t *keys = node->type == Node4 ? static_cast<const Inner4*>(node)->keys
+                                                               : static_cast<const Inner16*>(node)->keys;
+                Node* const *children = node->type == Node4 ? static_cast<const Inner4*>(node)->children
+                                                            : static_cast<const Inner16*>(node)->children;
+                for(int i = node->count - 1; i >= 0; --i) {
+                    if(keys[i] <= from) {
+                        child = children[i];
+                        return keys[i];
+                    }
+                }
+                return -1;
+            }
+            case Node48: {
+                const Inner48 *inner = static_cast<const Inner48*>(node);
+                for(int byte = from; byte >= 0; --byte) {
+                    if(inner->index[byte] != 0) {
+                        child = inner->children[inner->index[byte] - 1];
+                        return byte;
+                    }
+                }
+                return -1;
+            }
+            default: {
+                const Inner256 *inner = static_cast<const Inner256*>(node);
+                for(int byte = from; byte >= 0; --byte) {
+                    if(inner->children[byte] != nullptr) {
+                        child = inner->children[byte];
+                        return byte;
+                    }
+                }
+                return -1;
+            }
+        }
+    }
+
+    // keys of Node4 and Node16 are kept sorted
+    template <typename Sorted>
+    static void insertSorted(Sorted* node, std::uint8_t byte, Node* child) {
+        int i = node->count;
+        for(; i > 0 && node->keys[i - 1] > byte; --i) {
+            node->keys[i] = node->keys[i - 1];
+            node->children[i] = node->children[i - 1];
+        }
+        node->keys[i] = byte;
+        node->children[i] = child;
+        ++node->count;
+    }
+
+    template <typename Sorted>
+    static void eraseSorted(Sorted* node, std::uint8_t byte) {
+        int i = 0;
+        while(node->keys[i] != byte)
+            ++i;
+        for(--node->count; i < node->count; ++i) {
+            node->keys[i] = node->keys[i + 1];
+            node->children[i] = node->children[i + 1];
+        }
+    }
+
+    // grows node into the next size when full, ref is updated to the replacement
+    static void addChild(Node*& ref, Inner* node, std::uint8_t byte, Node* child) {
+        switch(node->type) {
+            case Node4: {
+                Inner4 *inner = static_cast<Inner4*>(node);
+                if(inner->count < 4) {
+                    insertSorted(inner, byte, child);
+                    return;
+                }
+
+                Inner16 *grown = new Inner16(inner->prefix);
+                for(int i = 0; i < inner->count; ++i)
+                    insertSorted(grown, inner->keys[i], inner->children[i]);
+                insertSorted(grown, byte, child);
+                ref = grown;
+                delete inner;
+                return;
+            }
+            case Node16: {
+                Inner16 *inner = static_cast<Inner16*>(node);
+                if(inner->count < 16) {
+                    insertSorted(inner, byte, child);
+                    return;
+                }
+
+                Inner48 *grown = new Inner48(inner->prefix);
+                for(int i = 0; i < inner->count; ++i)
+                    grown->add(inner->keys[i], inner->children[i]);
+                grown->add(byte, child);
+                ref = grown;
+                delete inner;
+                return;
+            }
+            case Node48: {
+                Inner48 *inner = static_cast<Inner48*>(node);
+                if(inner->count < 48) {
+                    inner->add(byte, child);
+                    return;
+                }
+
+                Inner256 *grown = new Inner256(inner->prefix);
+                for(int i = 0; i < 256; ++i)
+                    if(inner->index[i] != 0) grown->children[i] = inner->children[inner->index[i] - 1];
+                grown->count = inner->count;
+                grown->children[byte] = child;
+                ++grown->count;
+                ref = grown;
+                delete inner;
+                return;
+            }
+            default: {
+                Inner256 *inner = static_cast<Inner256*>(node);
+                inner->children[byte] = child;
+                ++inner->count;
+                return;
+            }
+        }
+    }
+
+    // shrinks node once it gets sparse, a lone child absorbs its parent's prefix
+    static void removeChild(Node*& ref, Inner* node, std::uint8_t byte) {
+        switch(node->type) {
+            case Node4: {
+                Inner4 *inner = static_cast<Inner4*>(node);
+                eraseSorted(inner, byte);
+                if(inner->count > 1) return;
+
+                Node *only = inner->children[0];
+                if(only->type != LeafNode) {
+                    Inner *child = static_cast<Inner*>(only);
+                    child->prefix.insert(0, 1, static_cast<char>(inner->keys[0]));
+                    child->prefix.insert(0, inner->prefix);
+                }
+                ref = only;
+                delete inner;
+                return;
+            }
+            case Node16: {
+                Inner16 *inner = static_cast<Inner16*>(node);
+                eraseSorted(inner, byte);
+                if(inner->count > 3) return;
+
+                Inner4 *shrunk = new Inner4(inner->prefix);
+                for(int i = 0; i < inner->count; ++i)
+                    insertSorted(shrunk, inner->keys[i], inner->children[i]);
+                ref = shrunk;
+                delete inner;
+                return;
+            }
+            case Node48: {
+                Inner48 *inner = static_cast<Inner48*>(node);
+                inner->children[inner->index[byte] - 1] = nullptr;
+                inner->index[byte] = 0;
+                if(--inner->count > 12) return;
+
+                Inner16 *shrunk = new Inner16(inner->prefix);
+                for(int i = 0; i < 256; ++i)
+                    if(inner->index[i] != 0)
+                        insertSorted(shrunk, static_cast<std::uint8_t>(i), inner->children[inner->index[i] - 1]);
+                ref = shrunk;
+                delete inner;
+                return;
+            }
+            default: {
+                Inner256 *inner = static_cast<Inner256*>(node);
+                inner->children[byte] = nullptr;
+                if(--inner->count > 37) return;
+
+                Inner48 *shrunk = new Inner48(inner->prefix);
+                for(int i = 0; i < 256; ++i)
+                    if(inner->children[i] != nullptr) shrunk->add(static_cast<std::uint8_t>(i), inner->children[i]);
+                ref = shrunk;
+                delete inner;
+                return;
+            }
+        }
+    }
+
+    static void destroy(Node* node) {
+        if(node == nullptr) return;
+
+        switch(node->type) {
+            case LeafNode:
+                delete static_cast<Leaf*>(node);
+                return;
+            case Node4: {
+                Inner4 *inner = static_cast<Inner4*>(node);
+                for(int i = 0; i < inner->count; ++i)
+                    destroy(inner->children[i]);
+                delete inner;
+                return;
+            }
+            case Node16: {
+                Inner16 *inner = static_cast<Inner16*>(node);
+                for(int i = 0; i < inner->count; ++i)
+                    destroy(inner->children[i]);
+                delete inner;
+                return;
+            }
+            case Node48: {
+                Inner48 *inner = static_cast<Inner48*>(node);
+                for(int i = 0; i < 48; ++i)
+                    destroy(inner->children[i]);
+                delete inner;
+                return;
+            }
+            default: {
+                Inner256 *inner = static_cast<Inner256*>(node);
+                for(int i = 0; i < 256; ++i)
+                    destroy(inner->children[i]);
+                delete inner;
+                return;
+            }
+        }
+    }
+};
+
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Node
+{
+    NodeType type;
+
+    explicit Node(NodeType type) : type(type) {}
+};
+
+// holds the whole key, so prefixes above it need not be compared on lookup;
+// its encoding is recomputed where the bytes themselves are needed
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Leaf : Node
+{
+    value_type value;
+
+    explicit Leaf(const key_type& key) : Node(LeafNode), value(key, mapped_type()) {}
+};
+
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Inner : Node
+{
+    std::uint16_t count;
+    Prefix prefix; //bytes shared by all keys below, skipped on the way down
+
+    Inner(NodeType type, const Prefix& prefix) : Node(type), count(0), prefix(prefix) {}
+};
+
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Inner4 : Inner
+{
+    std::uint8_t keys[4];
+    Node *children[4];
+
+    explicit Inner4(const Prefix& prefix) : Inner(Node4, prefix) {}
+};
+
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Inner16 : Inner
+{
+    std::uint8_t keys[16];
+    Node *children[16];
+
+    explicit Inner16(const Prefix& prefix) : Inner(Node16, prefix) {
+        std::memset(keys, 0, sizeof(keys));
+    }
+};
+
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Inner48 : Inner
+{
+    std::uint8_t index[256]; //slot + 1 of a byte's child, 0 when absent
+    Node *children[48];
+
+    explicit Inner48(const Prefix& prefix) : Inner(Node48, prefix) {
+        std::memset(index, 0, sizeof(index));
+        std::memset(children, 0, sizeof(children));
+    }
+
+    void add(std::uint8_t byte, Node* child) {
+        int slot = 0;
+        while(children[slot] != nullptr)
+            ++slot;
+        children[slot] = child;
+        index[byte] = static_cast<std::uint8_t>(slot + 1);
+        ++this->count;
+    }
+};
+
+template <typename KeyType, typename ValueType>
+struct RadixTreeMap<KeyType, ValueType>::Inner256 : Inner
+{
+    Node *children[256];
+
+    explicit Inner256(const Prefix& prefix) : Inner(Node256, prefix) {
+        std::memset(children, 0, sizeof(children));
+    }
+};
+
+template <typename KeyType, typename ValueType>
+class RadixTreeMap<KeyType, ValueType>::ConstIterator
+{
+    friend class RadixTreeMap;
+
+    const RadixTreeMap *map;
+    typename RadixTreeMap::Path path;
+    const Leaf *leaf; //nullptr at end
+
+    explicit ConstIterator(const RadixTreeMap *map) : map(map), leaf(nullptr)
+    {}
+
+public:
+  using reference = typename RadixTreeMap::const_reference;
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = typename RadixTreeMap::value_type;
+  using pointer = const typename RadixTreeMap::value_type*;
+  using difference_type = std::ptrdiff_t;
+
+  explicit ConstIterator() : map(nullptr), leaf(nullptr)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(leaf == nullptr)
+        throw std::out_of_range("No access");
+
+    leaf = RadixTreeMap::advance(path);
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator it(*this);
+    ++(*this);
+    return it;
+  }
+
+  ConstIterator& operator--()
+  {
+    if(map == nullptr || map->root == nullptr)
+        throw std::out_of_range("No access");
+
+    if(leaf == nullptr) {
+        leaf = RadixTreeMap::descendLast(map->root, path);
+        return *this;
+    }
+
+    typename RadixTreeMap::Path previous(path);
+    const Leaf *tmp = RadixTreeMap::retreat(previous);
+    if(tmp == nullptr)
+        throw std::out_of_range("No access"); //begin
+
+    leaf = tmp;
+    path.swap(previous);
+    return *this;
+  }
+
+  ConstIterator operator--(int)
+  {
+    ConstIterator it(*this);
+    --(*this);
+    return it;
+  }
+
+  reference operator*() const
+  {
+    if(leaf == nullptr)
+        throw std::out_of_range("No access");
+    return leaf->value;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return map == other.map && leaf == other.leaf;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class RadixTreeMap<KeyType, ValueType>::Iterator : public RadixTreeMap<KeyType, ValueType>::ConstIterator
+{
+public:
+  using reference = typename RadixTreeMap::reference;
+  using pointer = typename RadixTreeMap::value_type*;
+
+  explicit Iterator()
+  {}
+
+  Iterator(const ConstIterator& other)
+    : ConstIterator(other)
+  {}
+
+  Iterator& operator++()
+  {
+    ConstIterator::operator++();
+    return *this;
+  }
+
+  Iterator operator++(int)
+  {
+    auto result = *this;
+    ConstIterator::operator++();
+    return result;
+  }
+
+  Iterator& operator--()
+  {
+    ConstIterator::operator--();
+    return *this;
+  }
+
+  Iterator operator--(int)
+  {
+    auto result = *this;
+    ConstIterator::operator--();
+    return result;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  reference operator*() const
+  {
+    return const_cast<reference>(ConstIterator::operator*());
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_RADIXTREEMAP_H */
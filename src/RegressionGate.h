@@ -0,0 +1,170 @@
+#ifndef AISDI_MAPS_REGRESSIONGATE_H
+#define AISDI_MAPS_REGRESSIONGATE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+
+namespace aisdi
+{
+
+// One-sided Mann-Whitney U test of whether samples of second tend to be larger than those of first.
+// Exact null distribution while there are no ties, the tie-corrected normal approximation otherwise.
+struct MannWhitney
+{
+  double u; //pairs where second is larger, ties counting one half
+  double pValue;
+
+  static MannWhitney test(const std::vector<double>& first, const std::vector<double>& second)
+  {
+    if(first.empty() || second.empty())
+        return { 0, 1 };
+
+    double u = 0;
+    bool ties = false;
+    for(double a : first)
+        for(double b : second) {
+            if(b > a)
+                u += 1;
+            else if(b == a) {
+                u += 0.5;
+                ties = true;
+            }
+        }
+
+    const std::size_t m = first.size(), n = second.size();
+    if(!ties && m * n <= 10000)
+        return { u, exactTail(m, n, static_cast<std::size_t>(u)) };
+    return { u, normalTail(first, second, u) };
+  }
+
+private:
+    // P(U >= u) when every ordering of the m + n samples is equally likely
+    static double exactTail(std::size_t m, std::size_t n, std::size_t u) {
+        // counts[j][k]: orderings of j firsts and i seconds with U = k, built up over i
+        const std::size_t maxU = m * n;
+        std::vector<std::vector<double>> counts(m + 1, std::vector<double>(maxU + 1, 0));
+        for(std::size_t j = 0; j <= m; ++j)
+            counts[j][0] = 1;
+        for(std::size_t i = 1; i <= n; ++i) {
+            std::vector<std::vector<double>> next(m + 1, std::vector<double>(maxU + 1, 0));
+            next[0][0] = 1;
+            for(std::size_t j = 1; j <= m; ++j)
+                for(std::size_t k = 0; k <= maxU; ++k) {
+                    // the largest sample is a second (beating all j firsts) or a first (beating nothing)
+                    next[j][k] = next[j - 1][k] + (k >= j ? counts[j][k - j] : 0);
+                }
+            counts.swap(next);
+        }
+        double total = 0, tail = 0;
+        for(std::size_t k = 0; k <= maxU; ++k) {
+            total += counts[m][k];
+            if(k >= u)
+                tail += counts[m][k];
+        }
+        return tail / total;
+    }
+
+    static double normalTail(const std::vector<double>& first, const std::vector<double>& second, double u) {
+        const double m = first.size(), n = second.size(), count = m + n;
+        std::vector<double> all(first);
+        all.insert(all.end(), second.begin(), second.end());
+        std::sort(all.begin(), all.end());
+        double tieTerm = 0;
+        for(std::size_t i = 0; i < all.size();) {
+            std::size_t j = i;
+            while(j < all.size() && all[j] == all[i])
+                ++j;
+            const double tied = j - i;
+            tieTerm += tied * tied * tied - tied;
+            i = j;
+        }
+        const double variance = m * n / 12 * ((count + 1) - tieTerm / (count * (count - 1)));
+        if(variance <= 0)
+            return 1;
+        const double z = (u - m * n / 2 - 0.5) / std::sqrt(variance);
+        return 0.5 * std::erfc(z / std::sqrt(2.0));
+    }
+};
+
+enum class RegressionVerdict
+{
+  Unchanged,
+  Faster,
+  Slower,
+  Missing, //in the baseline only
+  Added //in the current run only
+};
+
+struct RegressionCase
+{
+  std::string engine;
+  std::string operation;
+  double baselineMedian;
+  double currentMedian;
+  double pValue; //of the change in the direction of the medians
+  RegressionVerdict verdict;
+};
+
+// First case of current that baseline measured over a different number of operations, nullptr when
+// there is none. Timings of other sizes are not comparable; baselines from before counts were written have 0.
+inline const BenchmarkResult* differentWorkload(const std::vector<BenchmarkResult>& baseline,
+                                                const std::vector<BenchmarkResult>& current)
+{
+  for(const BenchmarkResult& after : current)
+      for(const BenchmarkResult& before : baseline)
+          if(before.engine == after.engine && before.operation == after.operation
+             && before.operations != after.operations)
+              return &after;
+  return nullptr;
+}
+
+// A case is Slower when its median grew by more than threshold (0.1 = 10%) and Mann-Whitney finds
+// the trial samples larger at the given significance, Faster for the mirrored shrink, both needed
+// so neither a noisy trial nor a tiny but consistent shift trips the gate.
+inline std::vector<RegressionCase> compareToBaseline(const std::vector<BenchmarkResult>& baseline,
+                                                     const std::vector<BenchmarkResult>& current,
+                                                     double threshold, double significance)
+{
+  std::vector<RegressionCase> cases;
+  for(const BenchmarkResult& before : baseline) {
+      auto after = std::find_if(current.begin(), current.end(), [&](const BenchmarkResult& result) {
+          return result.engine == before.engine && result.operation == before.operation;
+      });
+      if(after == current.end()) {
+          cases.push_back({ before.engine, before.operation, before.median, 0, 1, RegressionVerdict::Missing });
+          continue;
+      }
+
+      RegressionCase compared{ before.engine, before.operation, before.median, after->median, 1,
+                               RegressionVerdict::Unchanged };
+      if(after->median >= before.median) {
+          compared.pValue = MannWhitney::test(before.samples, after->samples).pValue;
+          if(after->median > before.median * (1 + threshold) && compared.pValue < significance)
+              compared.verdict = RegressionVerdict::Slower;
+      }
+      else {
+          compared.pValue = MannWhitney::test(after->samples, before.samples).pValue;
+          if(after->median * (1 + threshold) < before.median && compared.pValue < significance)
+              compared.verdict = RegressionVerdict::Faster;
+      }
+      cases.push_back(compared);
+  }
+
+  for(const BenchmarkResult& after : current) {
+      auto before = std::find_if(baseline.begin(), baseline.end(), [&](const BenchmarkResult& result) {
+          return result.engine == after.engine && result.operation == after.operation;
+      });
+      if(before == baseline.end())
+          cases.push_back({ after.engine, after.operation, 0, after.median, 1, RegressionVerdict::Added });
+  }
+  return cases;
+}
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_REGRESSIONGATE_H */
@@ -0,0 +1,481 @@
+#ifndef AISDI_MAPS_SHARDEDTREEMAP_H
+#define AISDI_MAPS_SHARDEDTREEMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TreeMap.h"
+
+namespace aisdi
+{
+
+// Key space split into ranges, each held by its own TreeMap and lock.
+// Item operations touch only the lock of their shard: the layout (split points
+// and shards) is published through an atomic pointer and never changed in place.
+// Resharding allocates a fresh layout, locks every shard, moves its items over
+// without allocating, then marks the old shards retired and swaps the pointer,
+// so a failed allocation leaves the old layout in use. An operation that finds
+// its shard retired reloads the layout and retries. Retired layouts are only empty shells, but a reader may
+// still be about to lock one of them: every operation announces the generation of
+// the layout it started in, and each layout change frees the retired layouts older
+// than every announced generation. So a retired layout outlives only the
+// operations that started before it was replaced.
+// Iterators are invalidated by resharding.
+template <typename KeyType, typename ValueType>
+class ShardedTreeMap
+{
+public:
+  using key_type = KeyType;
+  using mapped_type = ValueType;
+  using value_type = std::pair<const key_type, mapped_type>;
+  using size_type = std::size_t;
+  using const_reference = const value_type&;
+
+private:
+    using Tree = TreeMap<key_type, mapped_type>;
+
+    class Guard;
+
+    static const int slotCount = 64; //operations in progress at once, more wait for a free slot
+
+    // one cache line each, so threads announcing their generations do not share lines
+    struct Slot
+    {
+        std::atomic<std::uint64_t> generation; //0 when free
+        char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+
+        Slot() : generation(0) {}
+    };
+
+    // one cache line at least, so neighbouring shards do not share their locks' lines
+    struct alignas(64) Shard
+    {
+        mutable std::mutex lock;
+        Tree map;
+        bool retired = false; //guarded by lock
+    };
+
+    struct Layout
+    {
+        std::vector<key_type> bounds; //bounds[i] is the lowest key of shards[i + 1]
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::uint64_t generation = 1; //increases by one with every published layout
+
+        explicit Layout(const std::vector<key_type>& splitPoints) : bounds(splitPoints) {
+            for(size_type i = 0; i <= bounds.size(); ++i)
+                shards.emplace_back(new Shard());
+        }
+
+        size_type shardOf(const key_type& key) const {
+            return std::upper_bound(bounds.begin(), bounds.end(), key) - bounds.begin();
+        }
+    };
+
+    std::atomic<Layout*> layout;
+    std::atomic<std::uint64_t> generation; //of the published layout
+    mutable Slot slots[slotCount];
+    std::vector<std::unique_ptr<Layout>> retiredLayouts; //guarded by resharding
+    std::mutex resharding; //serializes layout changes, item operations never take it
+    size_type shardCount;
+
+public:
+  class ConstIterator;
+  using const_iterator = ConstIterator;
+
+  explicit ShardedTreeMap(size_type shardCount = 1)
+    : layout(new Layout(std::vector<key_type>())), generation(1), shardCount(std::max<size_type>(shardCount, 1))
+  {}
+
+  ShardedTreeMap(std::initializer_list<value_type> list) : ShardedTreeMap()
+  {
+    for(auto&& entry : list) {
+        insert(entry.first, entry.second);
+    }
+  }
+
+  ShardedTreeMap(const ShardedTreeMap& other) = delete;
+  ShardedTreeMap& operator=(const ShardedTreeMap& other) = delete;
+
+  ~ShardedTreeMap()
+  {
+    delete layout.load();
+  }
+
+  bool isEmpty() const
+  {
+    return getSize() == 0;
+  }
+
+  size_type getSize() const
+  {
+    Guard pinned(*this);
+    while(true) {
+        const Layout *current = layout.load();
+        size_type size = 0;
+        bool retired = false;
+        for(size_type i = 0; !retired && i < current->shards.size(); ++i) {
+            const Shard& shard = *current->shards[i];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            retired = shard.retired;
+            size += shard.map.getSize();
+        }
+        if(!retired) return size;
+    }
+  }
+
+  size_type getShardCount() const
+  {
+    Guard pinned(*this);
+    return layout.load()->shards.size();
+  }
+
+  void insert(const key_type& key, const mapped_type& value)
+  {
+    withShardOf(key, [&key, &value](Shard& shard) { shard.map[key] = value; });
+  }
+
+  mapped_type valueOf(const key_type& key) const
+  {
+    return withShardOf(key, [&key](Shard& shard) { return shard.map.valueOf(key); });
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return withShardOf(key, [&key](Shard& shard) { return shard.map.contains(key); });
+  }
+
+  void remove(const key_type& key)
+  {
+    if(!tryRemove(key))
+        throw std::out_of_range("No such element");
+  }
+
+  // returns false instead of throwing when key is missing
+  bool tryRemove(const key_type& key)
+  {
+    return withShardOf(key, [&key](Shard& shard) {
+        if(!shard.map.contains(key)) return false;
+        shard.map.remove(key);
+        return true;
+    });
+  }
+
+  // calls visit(item) for keys in [lo, hi), one shard locked at a time
+  template <typename Visitor>
+  void scan(const key_type& lo, const key_type& hi, Visitor visit) const
+  {
+    Guard pinned(*this);
+    key_type from = lo; //keys below it have been visited already
+    const Layout *current = layout.load();
+    size_type i = current->shardOf(from);
+
+    while(i < current->shards.size() && (i == 0 || current->bounds[i - 1] < hi)) {
+        const Shard& shard = *current->shards[i];
+        std::unique_lock<std::mutex> guard(shard.lock);
+        if(shard.retired) {
+            guard.unlock();
+            current = layout.load();
+            i = current->shardOf(from);
+            continue;
+        }
+
+        for(auto it = shard.map.lower_bound(from); it != shard.map.cend() && it->first < hi; ++it)
+            visit(*it);
+        if(i < current->bounds.size())
+            from = current->bounds[i];
+        ++i;
+    }
+  }
+
+  // picks shardCount - 1 split points as quantiles of samples and redistributes items
+  void reshard(std::vector<key_type> samples)
+  {
+    std::sort(samples.begin(), samples.end());
+    samples.erase(std::unique(samples.begin(), samples.end(),
+                              [](const key_type& a, const key_type& b) { return !(a < b) && !(b < a); }),
+                  samples.end());
+
+    std::vector<key_type> splitPoints;
+    for(size_type i = 1; i < shardCount && !samples.empty(); ++i) {
+        const key_type& point = samples[i * samples.size() / shardCount];
+        if(splitPoints.empty() || splitPoints.back() < point)
+            splitPoints.push_back(point);
+    }
+
+    std::unique_ptr<Layout> next(new Layout(splitPoints));
+    Tree upper;
+
+    std::lock_guard<std::mutex> exclusive(resharding);
+    retiredLayouts.reserve(retiredLayouts.size() + 1);
+    Layout *old = layout.load();
+    std::vector<std::unique_lock<std::mutex>> guards = lockAll(*old);
+
+    redistribute(*old, *next, upper);
+    publish(next.release());
+    guards.clear();
+    collect();
+  }
+
+  // cuts shards above 1.5 times the fair share into pieces of at most one share,
+  // then merges neighbours fitting in one share while there are too many shards
+  void rebalance()
+  {
+    Tree upper;
+
+    std::lock_guard<std::mutex> exclusive(resharding);
+    retiredLayouts.reserve(retiredLayouts.size() + 1);
+    Layout *old = layout.load();
+    std::vector<std::unique_lock<std::mutex>> guards = lockAll(*old);
+
+    // the new bounds depend on the shard sizes, so they are planned under the locks,
+    // but nothing is moved before the new layout is allocated
+    size_type size = 0;
+    for(auto& shard : old->shards)
+        size += shard->map.getSize();
+    const size_type fairShare = std::max<size_type>((size + shardCount - 1) / shardCount, 1);
+
+    std::vector<key_type> bounds;
+    std::vector<size_type> sizes;
+    for(size_type i = 0; i < old->shards.size(); ++i) {
+        if(i > 0) bounds.push_back(old->bounds[i - 1]);
+        const Tree& map = old->shards[i]->map;
+        const size_type shardSize = map.getSize();
+        const size_type pieces = shardSize > fairShare + fairShare / 2 ? (shardSize + fairShare - 1) / fairShare : 1;
+
+        // one walk over the shard finds the lowest key of every piece
+        size_type position = 0, piece = 1, pieceStart = 0;
+        for(auto it = map.cbegin(); piece < pieces; ++it, ++position) {
+            if(position == piece * shardSize / pieces) {
+                bounds.push_back(it->first);
+                sizes.push_back(position - pieceStart);
+                pieceStart = position;
+                ++piece;
+            }
+        }
+        sizes.push_back(shardSize - pieceStart);
+    }
+
+    for(size_type i = 0; i + 1 < sizes.size() && sizes.size() > shardCount;) {
+        if(sizes[i] + sizes[i + 1] <= fairShare) {
+            sizes[i] += sizes[i + 1];
+            sizes.erase(sizes.begin() + i + 1);
+            bounds.erase(bounds.begin() + i);
+        } else ++i;
+    }
+
+    std::unique_ptr<Layout> next(new Layout(bounds));
+    redistribute(*old, *next, upper);
+    publish(next.release());
+    guards.clear();
+    collect();
+  }
+
+  // iterators and range-for need the map to be left alone by writers
+  const_iterator cbegin() const
+  {
+    const Layout *current = layout.load(std::memory_order_acquire);
+    return ConstIterator(current, 0, current->shards[0]->map.cbegin()).skipEmpty();
+  }
+
+  const_iterator cend() const
+  {
+    const Layout *current = layout.load(std::memory_order_acquire);
+    return ConstIterator(current, current->shards.size(), typename Tree::const_iterator());
+  }
+
+  const_iterator begin() const
+  {
+    return cbegin();
+  }
+
+  const_iterator end() const
+  {
+    return cend();
+  }
+
+private:
+    // runs operation on the live shard owning key, under that shard's lock only
+    template <typename Operation>
+    auto withShardOf(const key_type& key, Operation operation) const -> decltype(operation(std::declval<Shard&>())) {
+        Guard pinned(*this);
+        while(true) {
+            const Layout *current = layout.load();
+            Shard& shard = *current->shards[current->shardOf(key)];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            if(!shard.retired)
+                return operation(shard);
+        }
+    }
+
+    static std::vector<std::unique_lock<std::mutex>> lockAll(Layout& current) {
+        std::vector<std::unique_lock<std::mutex>> guards;
+        guards.reserve(current.shards.size());
+        for(auto& shard : current.shards)
+            guards.emplace_back(shard->lock);
+        return guards;
+    }
+
+    // claims a free slot announcing the current generation, starting from one picked by the thread;
+    // the layout loaded afterwards is never older than the announced generation
+    Slot* pin() const {
+        static thread_local const std::size_t home = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+        while(true) {
+            for(int i = 0; i < slotCount; ++i) {
+                Slot& slot = slots[(home + i) % slotCount];
+                std::uint64_t free = 0;
+                if(slot.generation.load() == 0 && slot.generation.compare_exchange_strong(free, generation.load()))
+                    return &slot;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // callers still hold the old shards' locks, so operations waiting on them
+    // see them retired only once the new layout is visible. Cannot throw, the
+    // callers reserve room in retiredLayouts before they move any item.
+    void publish(Layout *next) {
+        Layout *old = layout.load();
+        for(auto& shard : old->shards)
+            shard->retired = true;
+        next->generation = old->generation + 1;
+        layout.store(next);
+        generation.store(next->generation);
+        retiredLayouts.emplace_back(old);
+    }
+
+    // frees retired layouts no operation in progress can have loaded,
+    // called with none of their locks held
+    void collect() {
+        std::uint64_t oldest = generation.load();
+        for(const Slot& slot : slots) {
+            const std::uint64_t announced = slot.generation.load();
+            if(announced != 0)
+                oldest = std::min(oldest, announced);
+        }
+        retiredLayouts.erase(std::remove_if(retiredLayouts.begin(), retiredLayouts.end(),
+                                            [oldest](const std::unique_ptr<Layout>& retired) {
+                                                return retired->generation < oldest;
+                                            }),
+                             retiredLayouts.end());
+    }
+
+    // moves every item of old into the shard of next owning its key. Shards are visited in key order,
+    // so every merge is disjoint and splits go through upper, which keeps its guard: nothing is allocated
+    static void redistribute(Layout& old, Layout& next, Tree& upper) {
+        for(auto& shard : old.shards) {
+            for(size_type i = next.bounds.size(); i > 0 && !shard->map.isEmpty(); --i) {
+                shard->map.split(next.bounds[i - 1], upper);
+                next.shards[i]->map.merge(std::move(upper));
+            }
+            next.shards[0]->map.merge(std::move(shard->map));
+        }
+    }
+};
+
+// Announces the generation of the current layout while alive, no layout of it or later is freed.
+template <typename KeyType, typename ValueType>
+class ShardedTreeMap<KeyType, ValueType>::Guard
+{
+    Slot *slot;
+
+public:
+  explicit Guard(const ShardedTreeMap& map) : slot(map.pin())
+  {}
+
+  Guard(const Guard&) = delete;
+  Guard& operator=(const Guard&) = delete;
+
+  ~Guard()
+  {
+    slot->generation.store(0);
+  }
+};
+
+template <typename KeyType, typename ValueType>
+class ShardedTreeMap<KeyType, ValueType>::ConstIterator
+{
+    friend class ShardedTreeMap;
+
+    using ShardIterator = typename ShardedTreeMap::Tree::const_iterator;
+
+    const typename ShardedTreeMap::Layout *map;
+    std::size_t shard;
+    ShardIterator it;
+
+    ConstIterator(const typename ShardedTreeMap::Layout *map, std::size_t shard, ShardIterator it)
+        : map(map), shard(shard), it(it)
+    {}
+
+    ConstIterator& skipEmpty() {
+        while(shard < map->shards.size() && it == map->shards[shard]->map.cend()) {
+            ++shard;
+            it = shard < map->shards.size() ? map->shards[shard]->map.cbegin() : ShardIterator();
+        }
+        return *this;
+    }
+
+public:
+  using reference = typename ShardedTreeMap::const_reference;
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename ShardedTreeMap::value_type;
+  using pointer = const typename ShardedTreeMap::value_type*;
+  using difference_type = std::ptrdiff_t;
+
+  explicit ConstIterator() : map(nullptr), shard(0)
+  {}
+
+  ConstIterator& operator++()
+  {
+    if(map == nullptr || shard >= map->shards.size())
+        throw std::out_of_range("No access");
+
+    ++it;
+    skipEmpty();
+    return *this;
+  }
+
+  ConstIterator operator++(int)
+  {
+    ConstIterator result(*this);
+    ++(*this);
+    return result;
+  }
+
+  reference operator*() const
+  {
+    if(map == nullptr || shard >= map->shards.size())
+        throw std::out_of_range("No access");
+    return *it;
+  }
+
+  pointer operator->() const
+  {
+    return &this->operator*();
+  }
+
+  bool operator==(const ConstIterator& other) const
+  {
+    return map == other.map && shard == other.shard && it == other.it;
+  }
+
+  bool operator!=(const ConstIterator& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+}
+
+#endif /* AISDI_MAPS_SHARDEDTREEMAP_H */
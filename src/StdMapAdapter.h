@@ -0,0 +1,117 @@
+#ifndef AISDI_MAPS_STDMAPADAPTER_H
+#define AISDI_MAPS_STDMAPADAPTER_H
+
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define AISDI_HAS_PMR 1
+#endif
+#endif
+
+namespace aisdi
+{
+
+// Standard container exposing the aisdi map interface, so it can run any benchmark as a baseline.
+template <typename Container>
+class StdMapAdapter : public Container
+{
+public:
+  using key_type = typename Container::key_type;
+  using mapped_type = typename Container::mapped_type;
+  using size_type = typename Container::size_type;
+
+  using Container::Container;
+
+  StdMapAdapter() = default;
+
+  bool isEmpty() const
+  {
+    return this->empty();
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    return this->at(key);
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    return this->at(key);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return this->find(key) != this->end();
+  }
+
+  void remove(const key_type& key)
+  {
+    if(this->erase(key) == 0)
+        throw std::out_of_range("Cannot remove not existing element");
+  }
+
+  size_type getSize() const
+  {
+    return this->size();
+  }
+};
+
+template <typename K, typename V>
+using StdMap = StdMapAdapter<std::map<K, V>>;
+
+template <typename K, typename V>
+using StdUnorderedMap = StdMapAdapter<std::unordered_map<K, V>>;
+
+#ifdef AISDI_HAS_PMR
+
+struct PoolResource
+{
+  std::pmr::unsynchronized_pool_resource pool;
+};
+
+// Every map owns its pool; the pool is a base so it is built before and destroyed after the items.
+template <typename Container>
+class PooledStdMapAdapter : private PoolResource, public StdMapAdapter<Container>
+{
+  using Base = StdMapAdapter<Container>;
+
+public:
+  PooledStdMapAdapter() : Base(&this->pool)
+  {}
+
+  PooledStdMapAdapter(const PooledStdMapAdapter& other) : Base(other, &this->pool)
+  {}
+
+  // pools differ, so items are moved one by one
+  PooledStdMapAdapter(PooledStdMapAdapter&& other) : Base(std::move(other), &this->pool)
+  {}
+
+  PooledStdMapAdapter& operator=(const PooledStdMapAdapter& other)
+  {
+    Base::operator=(other);
+    return *this;
+  }
+
+  PooledStdMapAdapter& operator=(PooledStdMapAdapter&& other)
+  {
+    Base::operator=(std::move(other));
+    return *this;
+  }
+};
+
+template <typename K, typename V>
+using PmrStdMap = PooledStdMapAdapter<std::pmr::map<K, V>>;
+
+template <typename K, typename V>
+using PmrStdUnorderedMap = PooledStdMapAdapter<std::pmr::unordered_map<K, V>>;
+
+#endif
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_STDMAPADAPTER_H */
@@ -0,0 +1,397 @@
+#ifndef AISDI_MAPS_TRACE_H
+#define AISDI_MAPS_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace aisdi
+{
+
+enum class TraceOperation : std::uint8_t
+{
+  Write, //operator[], the value size is the one assigned through the returned reference
+  Read, //valueOf
+  Find,
+  Remove,
+  Clear
+};
+
+enum class TraceKeyKind : std::uint8_t
+{
+  Signed,
+  Unsigned,
+  String
+};
+
+// Binary trace layout: the magic "AMT1", one TraceKeyKind byte, then per operation one TraceOperation byte,
+// the nanoseconds since the previous operation, the key and, for writes only, the value size.
+// Integers are LEB128 varints, signed keys zigzag encoded first, strings their length followed by the bytes.
+struct TraceFormat
+{
+  static const char* magic()
+  {
+    return "AMT1";
+  }
+
+  static void writeVarint(std::ostream& output, std::uint64_t value)
+  {
+    while(value >= 0x80) {
+        output.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    output.put(static_cast<char>(value));
+  }
+
+  static std::uint64_t readVarint(std::istream& input)
+  {
+    std::uint64_t value = 0;
+    for(unsigned int shift = 0; shift < 64; shift += 7) {
+        const int byte = input.get();
+        if(byte == std::char_traits<char>::eof())
+            throw std::runtime_error("Truncated trace");
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if((byte & 0x80) == 0)
+            return value;
+    }
+    throw std::runtime_error("Malformed varint in trace");
+  }
+
+  // reads the header, giving the kind of keys that follow
+  static TraceKeyKind readKind(std::istream& input)
+  {
+    char header[5];
+    if(!input.read(header, 5) || std::string(header, 4) != magic() || header[4] < 0
+       || header[4] > static_cast<char>(TraceKeyKind::String))
+        throw std::runtime_error("Not a map operation trace");
+    return static_cast<TraceKeyKind>(header[4]);
+  }
+};
+
+template <typename Key, typename Enable = void>
+struct TraceKey;
+
+template <typename Key>
+struct TraceKey<Key, typename std::enable_if<std::is_integral<Key>::value && std::is_signed<Key>::value>::type>
+{
+  static const TraceKeyKind kind = TraceKeyKind::Signed;
+
+  static void write(std::ostream& output, Key key)
+  {
+    const std::int64_t value = key;
+    TraceFormat::writeVarint(output, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+  }
+
+  static Key read(std::istream& input)
+  {
+    const std::uint64_t value = TraceFormat::readVarint(input);
+    return static_cast<Key>(static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1));
+  }
+};
+
+template <typename Key>
+struct TraceKey<Key, typename std::enable_if<std::is_integral<Key>::value && std::is_unsigned<Key>::value>::type>
+{
+  static const TraceKeyKind kind = TraceKeyKind::Unsigned;
+
+  static void write(std::ostream& output, Key key)
+  {
+    TraceFormat::writeVarint(output, key);
+  }
+
+  static Key read(std::istream& input)
+  {
+    return static_cast<Key>(TraceFormat::readVarint(input));
+  }
+};
+
+template <>
+struct TraceKey<std::string>
+{
+  static const TraceKeyKind kind = TraceKeyKind::String;
+
+  static void write(std::ostream& output, const std::string& key)
+  {
+    TraceFormat::writeVarint(output, key.size());
+    output.write(key.data(), key.size());
+  }
+
+  static std::string read(std::istream& input)
+  {
+    std::string key(TraceFormat::readVarint(input), '\0');
+    if(!input.read(&key[0], key.size()))
+        throw std::runtime_error("Truncated trace");
+    return key;
+  }
+};
+
+// bytes a value holds: the object itself, or the characters of a string
+template <typename Value>
+struct TraceValue
+{
+  static std::uint64_t sizeOf(const Value&)
+  {
+    return sizeof(Value);
+  }
+
+  static Value make(std::uint64_t)
+  {
+    return Value();
+  }
+};
+
+template <>
+struct TraceValue<std::string>
+{
+  static std::uint64_t sizeOf(const std::string& value)
+  {
+    return value.size();
+  }
+
+  static std::string make(std::uint64_t size)
+  {
+    return std::string(size, 'v');
+  }
+};
+
+template <typename Key>
+struct TraceRecord
+{
+  TraceOperation operation;
+  std::uint64_t delay; //nanoseconds since the previous record
+  Key key;
+  std::uint64_t valueSize;
+};
+
+template <typename Key>
+class TraceWriter
+{
+public:
+  explicit TraceWriter(std::ostream& output) : output(output), last(0)
+  {
+    output.write(TraceFormat::magic(), 4);
+    output.put(static_cast<char>(TraceKey<Key>::kind));
+  }
+
+  // timestamp in nanoseconds as given by now()
+  void record(TraceOperation operation, const Key& key, std::uint64_t valueSize, std::uint64_t timestamp)
+  {
+    output.put(static_cast<char>(operation));
+    TraceFormat::writeVarint(output, last == 0 || timestamp < last ? 0 : timestamp - last);
+    TraceKey<Key>::write(output, key);
+    if(operation == TraceOperation::Write)
+        TraceFormat::writeVarint(output, valueSize);
+    last = timestamp;
+  }
+
+  static std::uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+private:
+    std::ostream& output;
+    std::uint64_t last;
+};
+
+template <typename Key>
+class TraceReader
+{
+public:
+  explicit TraceReader(std::istream& input) : input(input)
+  {
+    if(TraceFormat::readKind(input) != TraceKey<Key>::kind)
+        throw std::runtime_error("Trace was recorded with another key type");
+  }
+
+  // false at the end of the trace
+  bool next(TraceRecord<Key>& record)
+  {
+    const int operation = input.get();
+    if(operation == std::char_traits<char>::eof())
+        return false;
+    if(operation > static_cast<int>(TraceOperation::Clear))
+        throw std::runtime_error("Unknown operation in trace");
+    record.operation = static_cast<TraceOperation>(operation);
+    record.delay = TraceFormat::readVarint(input);
+    record.key = TraceKey<Key>::read(input);
+    record.valueSize = record.operation == TraceOperation::Write ? TraceFormat::readVarint(input) : 0;
+    return true;
+  }
+
+private:
+    std::istream& input;
+};
+
+// Map recording every call that reaches the data into a TraceWriter, with no writer it only forwards.
+// A write is recorded when the next operation starts (or on flush), so the size of the value
+// assigned through operator[] is known; iteration is not recorded.
+template <typename Map>
+class RecordingMap
+{
+public:
+  using key_type = typename Map::key_type;
+  using mapped_type = typename Map::mapped_type;
+  using size_type = typename Map::size_type;
+  using iterator = typename Map::iterator;
+  using const_iterator = typename Map::const_iterator;
+
+  explicit RecordingMap(TraceWriter<key_type>* trace = nullptr) : trace(trace), pending(nullptr), pendingTime(0)
+  {}
+
+  RecordingMap(const RecordingMap&) = delete;
+  RecordingMap& operator=(const RecordingMap&) = delete;
+
+  ~RecordingMap()
+  {
+    flush();
+  }
+
+  // stops recording when trace is null
+  void setTrace(TraceWriter<key_type>* trace)
+  {
+    flush();
+    this->trace = trace;
+  }
+
+  void flush()
+  {
+    if(pending != nullptr && trace != nullptr)
+        trace->record(TraceOperation::Write, pendingKey, TraceValue<mapped_type>::sizeOf(*pending), pendingTime);
+    pending = nullptr;
+  }
+
+  mapped_type& operator[](const key_type& key)
+  {
+    const std::uint64_t time = start();
+    mapped_type& value = map[key];
+    if(trace != nullptr) {
+        pending = &value;
+        pendingKey = key;
+        pendingTime = time;
+    }
+    return value;
+  }
+
+  mapped_type& valueOf(const key_type& key)
+  {
+    record(TraceOperation::Read, key);
+    return map.valueOf(key);
+  }
+
+  const mapped_type& valueOf(const key_type& key) const
+  {
+    record(TraceOperation::Read, key);
+    return map.valueOf(key);
+  }
+
+  iterator find(const key_type& key)
+  {
+    record(TraceOperation::Find, key);
+    return map.find(key);
+  }
+
+  const_iterator find(const key_type& key) const
+  {
+    record(TraceOperation::Find, key);
+    return map.find(key);
+  }
+
+  bool contains(const key_type& key) const
+  {
+    record(TraceOperation::Find, key);
+    return map.contains(key);
+  }
+
+  void remove(const key_type& key)
+  {
+    record(TraceOperation::Remove, key);
+    map.remove(key);
+  }
+
+  void remove(const const_iterator& it)
+  {
+    record(TraceOperation::Remove, it->first);
+    map.remove(it);
+  }
+
+  void clear()
+  {
+    record(TraceOperation::Clear, key_type());
+    map.clear();
+  }
+
+  bool isEmpty() const
+  {
+    return map.isEmpty();
+  }
+
+  size_type getSize() const
+  {
+    return map.getSize();
+  }
+
+  iterator begin()
+  {
+    return map.begin();
+  }
+
+  iterator end()
+  {
+    return map.end();
+  }
+
+  const_iterator begin() const
+  {
+    return map.begin();
+  }
+
+  const_iterator end() const
+  {
+    return map.end();
+  }
+
+  const_iterator cbegin() const
+  {
+    return map.cbegin();
+  }
+
+  const_iterator cend() const
+  {
+    return map.cend();
+  }
+
+private:
+    Map map;
+    TraceWriter<key_type>* trace;
+    mutable const mapped_type* pending;
+    mutable key_type pendingKey;
+    mutable std::uint64_t pendingTime;
+
+    // flushes the pending write and stamps the operation about to run
+    std::uint64_t start() const {
+        if(trace == nullptr)
+            return 0;
+        const std::uint64_t time = TraceWriter<key_type>::now();
+        if(pending != nullptr) {
+            trace->record(TraceOperation::Write, pendingKey, TraceValue<mapped_type>::sizeOf(*pending), pendingTime);
+            pending = nullptr;
+        }
+        return time;
+    }
+
+    void record(TraceOperation operation, const key_type& key) const {
+        const std::uint64_t time = start();
+        if(trace != nullptr)
+            trace->record(operation, key, 0, time);
+    }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_TRACE_H */
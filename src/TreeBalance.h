@@ -0,0 +1,538 @@
+#ifndef AISDI_MAPS_TREEBALANCE_H
+#define AISDI_MAPS_TREEBALANCE_H
+
+#include <algorithm>
+#include <random>
+
+namespace aisdi
+{
+
+// Balancing policies for TreeMap. Nodes have left, right and parent links and an int `height`
+// the policy is free to use for its own state. The guard above the root is the only parentless node.
+//
+// A policy provides:
+//   created(node)        state of a new node
+//   update(node)         refreshes state after the children of node changed
+//   inserted(node)       rebalances after node was attached as a leaf
+//   erased(parent, child, fromLeft, state)
+//                        rebalances after a node holding state was spliced out from under parent
+//                        and replaced by child (possibly nullptr) on the given side
+//   accessed(node)       called for every node found by a lookup
+//   assigned(node)       the value of node was replaced through TreeMap::insert_or_assign
+//   join(left, pivot, right)
+//                        joins trees with all keys of left < pivot < all keys of right
+//   rank(node)           estimate of the subtree height
+//   boundedDepth         false when trees may degenerate. Such trees are rebuilt in O(n), `other` included,
+//                        before union, intersection and difference; self-adjusting ones splay the bounds
+//                        of split, range erase and disjoint merge to the root instead of rebuilding
+//   selfAdjusting        true when lookups move hits towards the root, so searches should stop at a match
+//   Augment              base of every node, room for data a policy derives from the subtree in update()
+// Hooks that can rotate the root away return the new root, nullptr when it stays the same.
+template <typename Policy>
+struct TreeBalance
+{
+    static const bool boundedDepth = true;
+    static const bool selfAdjusting = false;
+
+    struct Augment
+    {};
+
+    template <typename Node>
+    static void created(Node*) {}
+
+    template <typename Node>
+    static void update(Node*) {}
+
+    template <typename Node>
+    static Node* accessed(Node*) {
+        return nullptr;
+    }
+
+    template <typename Node>
+    static void assigned(Node*) {}
+
+    template <typename Node>
+    static int rank(Node* node) {
+        int spine = 0;
+        for(; node != nullptr; node = node->left)
+            ++spine;
+        return spine;
+    }
+
+    template <typename Node>
+    static bool isRoot(Node* node) {
+        return node->parent->parent == nullptr;
+    }
+
+    template <typename Node>
+    static Node* link(Node* left, Node* pivot, Node* right) {
+        pivot->left = left;
+        pivot->right = right;
+        pivot->parent = nullptr;
+
+        if(left != nullptr) left->parent = pivot;
+        if(right != nullptr) right->parent = pivot;
+        Policy::update(pivot);
+
+        return pivot;
+    }
+
+    template <typename Node>
+    static Node* rotateRight(Node* node) {
+        Node* tmp = node->left;
+        tmp->parent = node->parent;
+        node->left = tmp->right;
+
+        if(tmp->right != nullptr)
+            tmp->right->parent = node;
+
+        tmp->right = node;
+        node->parent = tmp;
+        Policy::update(node);
+        Policy::update(tmp);
+
+        if(tmp->parent != nullptr) {
+            if(tmp->parent->right == node)
+                tmp->parent->right = tmp;
+            else tmp->parent->left = tmp;
+        }
+
+        return tmp;
+    }
+
+    template <typename Node>
+    static Node* rotateLeft(Node* node) {
+        Node* tmp = node->right;
+        tmp->parent = node->parent;
+        node->right = tmp->left;
+
+        if(tmp->left != nullptr)
+            tmp->left->parent = node;
+
+        tmp->left = node;
+        node->parent = tmp;
+        Policy::update(node);
+        Policy::update(tmp);
+
+        if(tmp->parent != nullptr) {
+            if(tmp->parent->right == node)
+                tmp->parent->right = tmp;
+            else tmp->parent->left = tmp;
+        }
+
+        return tmp;
+    }
+};
+
+// Height-balanced, fewest levels for lookups. height is the subtree height.
+// Policy is the final policy, so one deriving from AvlBalanceOf sees every update().
+template <typename Policy>
+struct AvlBalanceOf : TreeBalance<Policy>
+{
+    using TreeBalance<Policy>::isRoot;
+    using TreeBalance<Policy>::link;
+    using TreeBalance<Policy>::rotateLeft;
+    using TreeBalance<Policy>::rotateRight;
+
+    template <typename Node>
+    static int height(Node* node) {
+        if(node == nullptr) return 0;
+        return node->height;
+    }
+
+    template <typename Node>
+    static void created(Node* node) {
+        node->height = 1;
+    }
+
+    template <typename Node>
+    static void update(Node* node) {
+        node->height = 1 + std::max(height(node->left), height(node->right));
+    }
+
+    template <typename Node>
+    static int rank(Node* node) {
+        return height(node);
+    }
+
+    template <typename Node>
+    static Node* inserted(Node* node) {
+        if(isRoot(node)) return nullptr;
+        return rebalance(node->parent);
+    }
+
+    template <typename Node>
+    static Node* erased(Node* parent, Node*, bool, int) {
+        if(parent->parent == nullptr) return nullptr;
+        return rebalance(parent);
+    }
+
+    template <typename Node>
+    static Node* join(Node* left, Node* pivot, Node* right) {
+        if(height(left) > height(right) + 1)
+            return joinRight(left, pivot, right);
+        if(height(right) > height(left) + 1)
+            return joinLeft(left, pivot, right);
+        return link(left, pivot, right);
+    }
+
+private:
+    // walks up from node, stops once a subtree keeps its former height
+    template <typename Node>
+    static Node* rebalance(Node* node) {
+        while(true) {
+            int oldHeight = node->height;
+            Policy::update(node);
+            int balance = height(node->left) - height(node->right);
+
+            if(balance == 2) {
+                if(height(node->left->left) < height(node->left->right))
+                    node->left = rotateLeft(node->left);
+                node = rotateRight(node);
+            } else if(balance == -2) {
+                if(height(node->right->right) < height(node->right->left))
+                    node->right = rotateRight(node->right);
+                node = rotateLeft(node);
+            }
+
+            if(isRoot(node)) return node;
+            if(node->height == oldHeight) return nullptr;
+            node = node->parent;
+        }
+    }
+
+    template <typename Node>
+    static Node* joinRight(Node* left, Node* pivot, Node* right) {
+        Node* sibling = left->left;
+        Node* middle = left->right;
+
+        if(height(middle) <= height(right) + 1) {
+            middle = link(middle, pivot, right);
+            if(height(middle) <= height(sibling) + 1)
+                return link(sibling, left, middle);
+            return rotateLeft(link(sibling, left, rotateRight(middle)));
+        }
+
+        middle = joinRight(middle, pivot, right);
+        link(sibling, left, middle);
+        if(height(middle) <= height(sibling) + 1)
+            return left;
+        return rotateLeft(left);
+    }
+
+    template <typename Node>
+    static Node* joinLeft(Node* left, Node* pivot, Node* right) {
+        Node* sibling = right->right;
+        Node* middle = right->left;
+
+        if(height(middle) <= height(left) + 1) {
+            middle = link(left, pivot, middle);
+            if(height(middle) <= height(sibling) + 1)
+                return link(middle, right, sibling);
+            return rotateRight(link(rotateLeft(middle), right, sibling));
+        }
+
+        middle = joinLeft(left, pivot, middle);
+        link(middle, right, sibling);
+        if(height(middle) <= height(sibling) + 1)
+            return right;
+        return rotateRight(right);
+    }
+};
+
+struct AvlBalance : AvlBalanceOf<AvlBalance>
+{};
+
+// Looser balance than AVL, at most two rotations per insert and three per removal.
+// height holds (black height << 1) | red, where black height counts black nodes down to nullptr.
+struct RedBlackBalance : TreeBalance<RedBlackBalance>
+{
+    template <typename Node>
+    static bool isRed(Node* node) {
+        return node != nullptr && (node->height & 1) != 0;
+    }
+
+    template <typename Node>
+    static int blackHeight(Node* node) {
+        if(node == nullptr) return 0;
+        return node->height >> 1;
+    }
+
+    template <typename Node>
+    static void paint(Node* node, bool red) {
+        int below = std::max(blackHeight(node->left), blackHeight(node->right));
+        node->height = ((below + (red ? 0 : 1)) << 1) | (red ? 1 : 0);
+    }
+
+    template <typename Node>
+    static void created(Node* node) {
+        node->height = 1; //red leaf
+    }
+
+    template <typename Node>
+    static void update(Node* node) {
+        paint(node, isRed(node));
+    }
+
+    template <typename Node>
+    static int rank(Node* node) {
+        return 2 * blackHeight(node);
+    }
+
+    template <typename Node>
+    static Node* inserted(Node* node) {
+        while(!isRoot(node) && isRed(node->parent)) {
+            Node* parent = node->parent;
+            if(isRoot(parent)) { //split can leave a red root
+                paint(parent, false);
+                return nullptr;
+            }
+
+            Node* grand = parent->parent;
+            bool parentLeft = grand->left == parent;
+            Node* uncle = parentLeft ? grand->right : grand->left;
+
+            if(isRed(uncle)) {
+                paint(parent, false);
+                paint(uncle, false);
+                paint(grand, true);
+                node = grand;
+                continue;
+            }
+
+            if(parentLeft) {
+                if(node == parent->right)
+                    parent = rotateLeft(parent);
+                paint(parent, false);
+                paint(grand, true);
+                node = rotateRight(grand);
+            } else {
+                if(node == parent->left)
+                    parent = rotateRight(parent);
+                paint(parent, false);
+                paint(grand, true);
+                node = rotateLeft(grand);
+            }
+            break;
+        }
+
+        if(!isRoot(node)) return nullptr;
+        paint(node, false);
+        return node;
+    }
+
+    template <typename Node>
+    static Node* erased(Node* parent, Node* child, bool fromLeft, int state) {
+        if((state & 1) != 0) return nullptr; //red leaf
+        if(isRed(child)) {
+            paint(child, false);
+            return nullptr;
+        }
+
+        Node* lowest = parent;
+        Node* top = nullptr;
+        Node* node = child;
+        bool left = fromLeft;
+        while(parent->parent != nullptr && !isRed(node)) {
+            Node* sibling = left ? parent->right : parent->left;
+            if(isRed(sibling)) {
+                paint(sibling, false);
+                paint(parent, true);
+                sibling = left ? rotateLeft(parent) : rotateRight(parent);
+                if(isRoot(sibling)) top = sibling;
+                sibling = left ? parent->right : parent->left;
+            }
+
+            Node* near = left ? sibling->left : sibling->right;
+            Node* far = left ? sibling->right : sibling->left;
+            if(!isRed(near) && !isRed(far)) {
+                paint(sibling, true);
+                node = parent;
+                parent = node->parent;
+                left = parent->left == node;
+                continue;
+            }
+
+            if(!isRed(far)) {
+                paint(near, false);
+                paint(sibling, true);
+                sibling = left ? rotateRight(sibling) : rotateLeft(sibling);
+                far = left ? sibling->right : sibling->left;
+            }
+
+            paint(sibling, isRed(parent));
+            paint(parent, false);
+            paint(far, false);
+            sibling = left ? rotateLeft(parent) : rotateRight(parent);
+            if(isRoot(sibling)) top = sibling;
+            node = nullptr;
+            break;
+        }
+        if(node != nullptr) paint(node, false);
+
+        // black heights above the removed node were left stale while fixing
+        for(; lowest->parent != nullptr; lowest = lowest->parent)
+            update(lowest);
+        return top;
+    }
+
+    template <typename Node>
+    static Node* join(Node* left, Node* pivot, Node* right) {
+        if(isRed(left)) paint(left, false);
+        if(isRed(right)) paint(right, false);
+
+        Node* joined;
+        if(blackHeight(left) > blackHeight(right))
+            joined = joinRight(left, pivot, right, blackHeight(right));
+        else if(blackHeight(right) > blackHeight(left))
+            joined = joinLeft(left, pivot, right, blackHeight(left));
+        else joined = link(left, pivot, right);
+
+        joined->parent = nullptr;
+        paint(joined, false);
+        return joined;
+    }
+
+private:
+    // descends the right spine of left to a black node as high as right
+    template <typename Node>
+    static Node* joinRight(Node* left, Node* pivot, Node* right, int target) {
+        if(!isRed(left) && blackHeight(left) == target) {
+            link(left, pivot, right);
+            paint(pivot, true);
+            return pivot;
+        }
+
+        Node* middle = joinRight(left->right, pivot, right, target);
+        link(left->left, left, middle);
+        if(!isRed(left) && isRed(middle) && isRed(middle->right)) {
+            paint(middle->right, false);
+            return rotateLeft(left);
+        }
+        return left;
+    }
+
+    template <typename Node>
+    static Node* joinLeft(Node* left, Node* pivot, Node* right, int target) {
+        if(!isRed(right) && blackHeight(right) == target) {
+            link(left, pivot, right);
+            paint(pivot, true);
+            return pivot;
+        }
+
+        Node* middle = joinLeft(left, pivot, right->left, target);
+        link(middle, right, right->right);
+        if(!isRed(right) && isRed(middle) && isRed(middle->left)) {
+            paint(middle->left, false);
+            return rotateRight(right);
+        }
+        return right;
+    }
+};
+
+// Randomized, a heap on random priorities kept in height. No rebalancing on removal.
+struct TreapBalance : TreeBalance<TreapBalance>
+{
+    template <typename Node>
+    static int priority(Node* node) {
+        if(node == nullptr) return -1;
+        return node->height;
+    }
+
+    template <typename Node>
+    static void created(Node* node) {
+        static thread_local std::minstd_rand generator(std::random_device{}());
+        node->height = static_cast<int>(generator() >> 1);
+    }
+
+    template <typename Node>
+    static Node* inserted(Node* node) {
+        while(!isRoot(node) && priority(node->parent) < priority(node)) {
+            if(node->parent->left == node)
+                rotateRight(node->parent);
+            else rotateLeft(node->parent);
+        }
+
+        return isRoot(node) ? node : nullptr;
+    }
+
+    template <typename Node>
+    static Node* erased(Node*, Node*, bool, int) {
+        return nullptr;
+    }
+
+    template <typename Node>
+    static Node* join(Node* left, Node* pivot, Node* right) {
+        if(priority(pivot) > priority(left) && priority(pivot) > priority(right))
+            return link(left, pivot, right);
+        if(priority(left) > priority(right))
+            return link(left->left, left, join(left->right, pivot, right));
+        return link(join(left, pivot, right->left), right, right->right);
+    }
+};
+
+// Self-adjusting, every accessed node is rotated to the root so hot keys stay near the top.
+// Lookups restructure the tree, so even const access must not be shared between threads.
+// Splits and range erasure are O(log n) amortized, but union, intersection and difference
+// first rebuild both trees in O(n), since their recursion would follow unbounded paths.
+struct SplayBalance : TreeBalance<SplayBalance>
+{
+    static const bool boundedDepth = false;
+    static const bool selfAdjusting = true;
+
+    template <typename Node>
+    static Node* accessed(Node* node) {
+        return splay(node);
+    }
+
+    template <typename Node>
+    static Node* inserted(Node* node) {
+        return splay(node);
+    }
+
+    template <typename Node>
+    static Node* erased(Node* parent, Node*, bool, int) {
+        if(parent->parent == nullptr) return nullptr;
+        return splay(parent);
+    }
+
+    template <typename Node>
+    static Node* join(Node* left, Node* pivot, Node* right) {
+        return link(left, pivot, right);
+    }
+
+private:
+    template <typename Node>
+    static Node* splay(Node* node) {
+        while(!isRoot(node)) {
+            Node* parent = node->parent;
+            bool leftChild = parent->left == node;
+
+            if(isRoot(parent)) {
+                if(leftChild) rotateRight(parent);
+                else rotateLeft(parent);
+            } else if((parent->parent->left == parent) == leftChild) {
+                Node* grand = parent->parent;
+                if(leftChild) {
+                    rotateRight(grand);
+                    rotateRight(parent);
+                } else {
+                    rotateLeft(grand);
+                    rotateLeft(parent);
+                }
+            } else if(leftChild) {
+                rotateRight(parent);
+                rotateLeft(node->parent);
+            } else {
+                rotateLeft(parent);
+                rotateRight(node->parent);
+            }
+        }
+
+        return node;
+    }
+};
+
+}
+
+#endif /* AISDI_MAPS_TREEBALANCE_H */
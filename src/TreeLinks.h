@@ -0,0 +1,116 @@
+#ifndef AISDI_MAPS_TREELINKS_H
+#define AISDI_MAPS_TREELINKS_H
+
+namespace aisdi
+{
+
+// In-order neighbour policies for TreeMap. The last node's successor is the guard, the guard's
+// predecessor is the last node and the first node has no predecessor.
+//
+// A policy provides:
+//   Fields<Node>         base of every node, holds whatever links the policy keeps
+//   next(node), prev(node)
+//                        in-order neighbours of a node of a tree hung under its guard
+//   thread(a, b)         makes a and b neighbours, either may be nullptr
+//   attached(node)       threads a leaf just attached below its parent
+//   detached(node)       unthreads a node about to be spliced out
+//   threaded             true when the links are stored, so neighbours survive relinking of the tree
+//
+// ThreadedLinks keeps prev/next in every node: iterator steps and the neighbour lookups of hinted
+// insert, split, range erase and erase are O(1), for two more pointers per node (56 instead of
+// 40 bytes for int keys and values). ParentLinks keeps nothing and walks parent links: iteration
+// is O(1) amortized per step, a single neighbour lookup O(log n), and nodes stay as small as
+// those of std::map. Prefer it for maps that are mostly looked up rather than iterated.
+struct ThreadedLinks
+{
+    static const bool threaded = true;
+
+    template <typename Node>
+    struct Fields
+    {
+        Node *prev = nullptr, *next = nullptr;
+    };
+
+    template <typename Node>
+    static Node* next(Node* node) {
+        return node->next;
+    }
+
+    template <typename Node>
+    static Node* prev(Node* node) {
+        return node->prev;
+    }
+
+    template <typename Node>
+    static void thread(Node* a, Node* b) {
+        if(a != nullptr) a->next = b;
+        if(b != nullptr) b->prev = a;
+    }
+
+    template <typename Node>
+    static void attached(Node* node) {
+        Node* parent = node->parent;
+        if(parent->left == node) {
+            thread(parent->prev, node);
+            thread(node, parent);
+        } else {
+            thread(node, parent->next);
+            thread(parent, node);
+        }
+    }
+
+    template <typename Node>
+    static void detached(Node* node) {
+        thread(node->prev, node->next);
+    }
+};
+
+struct ParentLinks
+{
+    static const bool threaded = false;
+
+    template <typename Node>
+    struct Fields
+    {};
+
+    template <typename Node>
+    static Node* next(Node* node) {
+        if(node->right != nullptr) {
+            node = node->right;
+            while(node->left != nullptr)
+                node = node->left;
+            return node;
+        }
+
+        while(node->parent->right == node)
+            node = node->parent;
+        return node->parent;
+    }
+
+    template <typename Node>
+    static Node* prev(Node* node) {
+        if(node->left != nullptr) {
+            node = node->left;
+            while(node->right != nullptr)
+                node = node->right;
+            return node;
+        }
+
+        while(node->parent != nullptr && node->parent->left == node)
+            node = node->parent;
+        return node->parent;
+    }
+
+    template <typename Node>
+    static void thread(Node*, Node*) {}
+
+    template <typename Node>
+    static void attached(Node*) {}
+
+    template <typename Node>
+    static void detached(Node*) {}
+};
+
+}
+
+#endif /* AISDI_MAPS_TREELINKS_H */
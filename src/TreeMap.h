@@ -1,15 +1,48 @@
 #ifndef AISDI_MAPS_TREEMAP_H
 #define AISDI_MAPS_TREEMAP_H
 
+#include <algorithm>
 #include <cstddef>
+#include <functional>
+#include <future>
 #include <initializer_list>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
+#include "FrozenTreeMap.h"
+#include "TreeBalance.h"
+#include "TreeLinks.h"
+
 namespace aisdi
 {
 
-template <typename KeyType, typename ValueType>
+// Orders a and b in one pass where Compare allows it, e.g. string::compare for std::less over strings.
+template <typename Compare, typename Key, typename Other>
+struct ThreeWayCompare : std::false_type
+{};
+
+template <typename Char, typename Traits, typename Alloc>
+struct ThreeWayCompare<std::less<std::basic_string<Char, Traits, Alloc>>,
+                       std::basic_string<Char, Traits, Alloc>, std::basic_string<Char, Traits, Alloc>> : std::true_type
+{
+    static int compare(const std::basic_string<Char, Traits, Alloc>& a, const std::basic_string<Char, Traits, Alloc>& b) {
+        return a.compare(b);
+    }
+};
+
+template <typename Char, typename Traits, typename Alloc>
+struct ThreeWayCompare<std::less<>, std::basic_string<Char, Traits, Alloc>, std::basic_string<Char, Traits, Alloc>>
+    : ThreeWayCompare<std::less<std::basic_string<Char, Traits, Alloc>>,
+                      std::basic_string<Char, Traits, Alloc>, std::basic_string<Char, Traits, Alloc>>
+{};
+
+// Balance picks the rebalancing scheme, see TreeBalance.h; Links whether nodes keep
+// in-order prev/next links, see TreeLinks.h.
+template <typename KeyType, typename ValueType, typename Compare = std::less<KeyType>,
+          typename Balance = AvlBalance, typename Links = ThreadedLinks>
 class TreeMap
 {
 public:
@@ -22,9 +55,9 @@ public:
 
 private:
     struct Node;
-    class AVLTree;
+    class BalancedTree;
 
-    AVLTree tree;
+    BalancedTree tree;
 
 public:
   class ConstIterator;
@@ -35,6 +68,9 @@ public:
   TreeMap()
   {}
 
+  explicit TreeMap(const Compare& compare) : tree(compare)
+  {}
+
   TreeMap(std::initializer_list<value_type> list)
   {
     for(auto&& entry : list) {
@@ -42,27 +78,24 @@ public:
     }
   }
 
-  TreeMap(const TreeMap& other)
+  TreeMap(const TreeMap& other) : tree(other.tree.compare)
   {
     for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
         tree.insert((*it).first, (*it).second);
     }
   }
 
-  TreeMap(TreeMap&& other)
-  {
-    this->tree.root = other.tree.root;
-    this->tree.size = other.tree.size;
-
-    other.tree.initAVLTree();
-  }
+  // takes over the guard as well, other gets a new one once it is filled again
+  TreeMap(TreeMap&& other) noexcept : tree(std::move(other.tree))
+  {}
 
   TreeMap& operator=(const TreeMap& other)
   {
     if(*this == other) return *this;
 
     tree.clear();
-    tree.initAVLTree();
+    tree.initTree();
+    tree.compare = other.tree.compare;
 
     for(ConstIterator it = other.cbegin(); it != other.cend(); ++it) {
         tree.insert((*it).first, (*it).second);
@@ -71,15 +104,12 @@ public:
     return *this;
   }
 
-  TreeMap& operator=(TreeMap&& other)
+  TreeMap& operator=(TreeMap&& other) noexcept
   {
-    if(*this == other) return *this;
-
-    this->tree.clear();
-    this->tree.root = other.tree.root;
-    this->tree.size = other.tree.size;
+    if(this == &other) return *this;
 
-    other.tree.initAVLTree();
+    tree.swap(other.tree);
+    other.tree.removeAll();
 
     return *this;
   }
@@ -89,11 +119,39 @@ public:
     return tree.getSize() == 0;
   }
 
+  Compare key_comp() const
+  {
+    return tree.compare;
+  }
+
   mapped_type& operator[](const key_type& key)
   {
     return tree.insert(key)->value.second;
   }
 
+  iterator insert(const_iterator hint, const key_type& key, const mapped_type& value)
+  {
+    Node *tmp = tree.insertHint(hint.current, key, value);
+    return Iterator(ConstIterator(tmp, tree.getFirstNode()));
+  }
+
+  // unlike assigning through operator[], lets the balance policy see the new value
+  iterator insert_or_assign(const key_type& key, const mapped_type& value)
+  {
+    Node *tmp = tree.insert(key, value);
+    tmp->value.second = value;
+    Balance::assigned(tmp);
+    return Iterator(ConstIterator(tmp, tree.getFirstNode()));
+  }
+
+  // constructs mapped value from args, existing key is left untouched
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, const key_type& key, Args&&... args)
+  {
+    Node *tmp = tree.insertHint(hint.current, key, mapped_type(std::forward<Args>(args)...));
+    return Iterator(ConstIterator(tmp, tree.getFirstNode()));
+  }
+
   const mapped_type& valueOf(const key_type& key) const
   {
     Node *tmp = tree.findKey(key);
@@ -110,6 +168,25 @@ public:
     return tmp->value.second;
   }
 
+  // lookup by anything Compare can order against keys, without building a key_type
+  template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+  const mapped_type& valueOf(const Key& key) const
+  {
+    Node *tmp = tree.findKey(key);
+    if(tmp == nullptr)
+        throw std::out_of_range("No such element");
+    return tmp->value.second;
+  }
+
+  template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+  mapped_type& valueOf(const Key& key)
+  {
+    Node *tmp = tree.findKey(key);
+    if(tmp == nullptr)
+        throw std::out_of_range("No such element");
+    return tmp->value.second;
+  }
+
   const_iterator find(const key_type& key) const
   {
     Node *tmp = tree.findKey(key);
@@ -124,6 +201,50 @@ public:
     return Iterator(ConstIterator(tmp, tree.getFirstNode()));
   }
 
+  template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator find(const Key& key) const
+  {
+    Node *tmp = tree.findKey(key);
+    if(tmp == nullptr) return cend();
+    return ConstIterator(tmp, tree.getFirstNode());
+  }
+
+  template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+  iterator find(const Key& key)
+  {
+    Node *tmp = tree.findKey(key);
+    if(tmp == nullptr) return end();
+    return Iterator(ConstIterator(tmp, tree.getFirstNode()));
+  }
+
+  bool contains(const key_type& key) const
+  {
+    return tree.findKey(key) != nullptr;
+  }
+
+  // first item with key not less than the given one
+  const_iterator lower_bound(const key_type& key) const
+  {
+    return ConstIterator(tree.lowerBound(key), tree.getFirstNode());
+  }
+
+  iterator lower_bound(const key_type& key)
+  {
+    return Iterator(ConstIterator(tree.lowerBound(key), tree.getFirstNode()));
+  }
+
+  template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+  const_iterator lower_bound(const Key& key) const
+  {
+    return ConstIterator(tree.lowerBound(key), tree.getFirstNode());
+  }
+
+  template <typename Key, typename C = Compare, typename = typename C::is_transparent>
+  iterator lower_bound(const Key& key)
+  {
+    return Iterator(ConstIterator(tree.lowerBound(key), tree.getFirstNode()));
+  }
+
   void remove(const key_type& key)
   {
     tree.deleteKey(key);
@@ -134,11 +255,123 @@ public:
     tree.deleteKey(it->first);
   }
 
+  // hands the root (nullptr when empty) and key_comp() to query, for lookups
+  // over data an augmenting balance policy keeps in the nodes
+  template <typename Query>
+  auto query(Query query) const -> decltype(query(static_cast<const Node*>(nullptr), std::declval<const Compare&>()))
+  {
+    const Node *root = tree.getSize() == 0 ? nullptr : tree.root;
+    return query(root, tree.compare);
+  }
+
+  // read-only copy laid out for fast lookups
+  FrozenTreeMap<key_type, mapped_type, Compare> freeze() const
+  {
+    return FrozenTreeMap<key_type, mapped_type, Compare>(cbegin(), cend(), key_comp());
+  }
+
+  // moves all items with keys not less than key into the returned map
+  TreeMap split(const key_type& key)
+  {
+    TreeMap other(tree.compare);
+    split(key, other);
+    return other;
+  }
+
+  // same, into upper, which has to be empty; allocates nothing when upper was not moved from
+  void split(const key_type& key, TreeMap& upper)
+  {
+    if(!upper.isEmpty())
+        throw std::invalid_argument("Split target is not empty");
+    if(this == &upper) return;
+
+    upper.tree.ensureGuard();
+    tree.splitOff(key, upper.tree);
+  }
+
+  // removes items with keys in [lo, hi)
+  void erase_range(const key_type& lo, const key_type& hi)
+  {
+    tree.eraseRange(lo, hi);
+  }
+
+  TreeMap extract_range(const key_type& lo, const key_type& hi)
+  {
+    TreeMap other(tree.compare);
+    tree.extractRange(lo, hi, other.tree);
+    return other;
+  }
+
+  // items of other with keys already present here are dropped
+  void merge(TreeMap&& other)
+  {
+    if(this == &other || tree.joinDisjoint(other.tree)) return;
+
+    tree.unionWith(std::move(other.tree));
+  }
+
+  // values already present here win over the ones from other
+  void union_with(const TreeMap& other)
+  {
+    if(this == &other) return;
+    tree.unionWith(other.tree);
+  }
+
+  void intersect_with(const TreeMap& other)
+  {
+    if(this == &other) return;
+    tree.intersectWith(other.tree);
+  }
+
+  // removes all keys present in other
+  void difference(const TreeMap& other)
+  {
+    if(this == &other) {
+        clear();
+        return;
+    }
+    tree.differenceWith(other.tree);
+  }
+
   size_type getSize() const
   {
     return tree.getSize();
   }
 
+  void clear()
+  {
+    tree.clear();
+    tree.initTree();
+  }
+
+  const_reference front() const
+  {
+    if(isEmpty())
+        throw std::out_of_range("No such element");
+    return tree.getFirstNode()->value;
+  }
+
+  reference front()
+  {
+    if(isEmpty())
+        throw std::out_of_range("No such element");
+    return tree.getFirstNode()->value;
+  }
+
+  const_reference back() const
+  {
+    if(isEmpty())
+        throw std::out_of_range("No such element");
+    return tree.getRightmostNode()->value;
+  }
+
+  reference back()
+  {
+    if(isEmpty())
+        throw std::out_of_range("No such element");
+    return tree.getRightmostNode()->value;
+  }
+
   bool operator==(const TreeMap& other) const
   {
     if(this->tree.getSize() != other.getSize()) return false;
@@ -187,98 +420,158 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-struct TreeMap<KeyType, ValueType>::Node
+template <typename KeyType, typename ValueType, typename Compare, typename Balance, typename Links>
+struct TreeMap<KeyType, ValueType, Compare, Balance, Links>::Node : Balance::Augment, Links::template Fields<Node>
 {
     using key_type = typename TreeMap::key_type;
     using mapped_type = typename TreeMap::mapped_type;
 
     Node *left, *right, *parent;
+    int height; //balancing state, AVL height by default
     std::pair<const key_type, mapped_type> value;
 
     Node(const key_type key, mapped_type mapped_value) : value(key, mapped_value) {
         this->left = this->right = this->parent = nullptr;
+        this->height = 1;
     }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::AVLTree
+template <typename KeyType, typename ValueType, typename Compare, typename Balance, typename Links>
+class TreeMap<KeyType, ValueType, Compare, Balance, Links>::BalancedTree
 {
 public:
-    Node* root;
+    mutable Node* root; //splaying moves it on lookups, nullptr without a guard
+    Node* leftmost; //guard when empty, nullptr without a guard
+    Node* rightmost; //nullptr when empty
     std::size_t size;
+    Compare compare;
 
     using key_type = typename TreeMap::key_type;
     using mapped_type = typename TreeMap::mapped_type;
     using size_type = std::size_t;
 
-    AVLTree() {
+    explicit BalancedTree(const Compare& compare = Compare()) : compare(compare) {
         root = new Node(key_type(), mapped_type()); //guard
+        leftmost = root;
+        rightmost = nullptr;
         size = 0;
     }
 
+    // leaves other without a guard, it allocates one when items are added again
+    BalancedTree(BalancedTree&& other) noexcept
+        : root(other.root), leftmost(other.leftmost), rightmost(other.rightmost), size(other.size),
+          compare(std::move(other.compare)) {
+        other.root = other.leftmost = other.rightmost = nullptr;
+        other.size = 0;
+    }
+
     Node* insert(const key_type& key) {
         return insert(key, mapped_type());
     }
 
     Node* insert(const key_type& key, mapped_type mapped_value) {
         if(size == 0) {
+            ensureGuard();
+
             Node* node = new Node(key, mapped_value);
+            Balance::created(node);
             node->parent = root; //root is a guard
             root->left = node;
+            thread(node, root);
             root = node;
+            leftmost = rightmost = node;
             ++size;
+            Balance::inserted(node);
             return root;
         }
 
-        Node* current = root;
-        while(true) {
-            if(current->value.first == key)
-                return current;
-
-            if(current->value.first > key) {
-                if(current->left == nullptr) {
-                    current->left = new Node(key, mapped_value);
-                    current->left->parent = current;
-                    Node* created = current->left;
-                    ++size;
-                    rebalance(current);
-
-                    return created;
-                } else {
-                    current = current->left;
-                    continue;
-                }
-            } else {
-                if(current->right == nullptr) {
-                    current->right = new Node(key, mapped_value);
-                    current->right->parent = current;
-                    Node* created = current->right;
-                    ++size;
-                    rebalance(current);
-
-                    return created;
-                } else {
-                    current = current->right;
-                    continue;
-                }
-            }
+        if(compare(rightmost->value.first, key))
+            return attach(rightmost, false, key, mapped_value);
+        if(compare(key, leftmost->value.first))
+            return attach(leftmost, true, key, mapped_value);
+
+        Node* parent = nullptr;
+        bool asLeft = false;
+        Node* found = locate(key, parent, asLeft, Descent<key_type>());
+        if(found != nullptr) return accessed(found);
+        return attach(parent, asLeft, key, mapped_value);
+    }
+
+    // hint is the node expected to follow key, guard stands for end
+    Node* insertHint(Node* hint, const key_type& key, mapped_type mapped_value) {
+        if(size == 0 || hint == nullptr)
+            return insert(key, mapped_value);
+
+        if(hint->parent == nullptr) {
+            if(compare(rightmost->value.first, key))
+                return attach(rightmost, false, key, mapped_value);
+            return insert(key, mapped_value);
         }
+
+        if(compare(key, hint->value.first)) {
+            if(hint == leftmost)
+                return attach(hint, true, key, mapped_value);
+
+            Node* previous = Links::prev(hint);
+            if(compare(previous->value.first, key)) {
+                if(hint->left == nullptr)
+                    return attach(hint, true, key, mapped_value);
+                return attach(previous, false, key, mapped_value);
+            }
+        } else if(compare(hint->value.first, key)) {
+            if(hint == rightmost)
+                return attach(hint, false, key, mapped_value);
+
+            Node* next = Links::next(hint);
+            if(compare(key, next->value.first)) {
+                if(hint->right == nullptr)
+                    return attach(hint, false, key, mapped_value);
+                return attach(next, true, key, mapped_value);
+            }
+        } else return hint;
+
+        return insert(key, mapped_value);
     }
 
-    Node* findKey(const key_type& key) const {
+    template <typename Key>
+    Node* findKey(const Key& key) const {
         if(size == 0) return nullptr;
-        Node* current = root;
 
+        Node* parent = nullptr;
+        bool asLeft = false;
+        Node* found = locate(key, parent, asLeft, Descent<Key>());
+        return found == nullptr ? nullptr : accessed(found);
+    }
+
+    template <typename Key>
+    Node* lowerBound(const Key& key) const {
+        if(size == 0) return root;
+
+        Node* current = root;
+        Node* bound = root->parent; //end
         while(current != nullptr) {
-            if(current->value.first > key)
-                current = current->left;
-            else if(current->value.first < key)
+            if(compare(current->value.first, key))
                 current = current->right;
-            else break;
+            else {
+                bound = current;
+                current = current->left;
+            }
         }
 
-        return current;
+        return bound;
+    }
+
+    void swap(BalancedTree& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(leftmost, other.leftmost);
+        std::swap(rightmost, other.rightmost);
+        std::swap(size, other.size);
+        std::swap(compare, other.compare);
+    }
+
+    // frees every item but keeps the guard
+    void removeAll() noexcept {
+        deleteNode(detach());
     }
 
     void clear() {
@@ -294,11 +587,11 @@ public:
     }
 
     Node* getFirstNode() const {
-        Node *tmp = root;
-        while(tmp->left != nullptr)
-            tmp = tmp->left;
+        return leftmost;
+    }
 
-        return tmp;
+    Node* getRightmostNode() const {
+        return rightmost;
     }
 
     Node* getLastNode() const {
@@ -306,173 +599,678 @@ public:
         return root->parent;
     }
 
-    void initAVLTree() {
+    void initTree() {
         root = new Node(key_type(), mapped_type()); //set guard
+        leftmost = root;
+        rightmost = nullptr;
         size = 0;
     }
 
+    // a moved-from tree has none, it is allocated before anything is detached or attached
+    void ensureGuard() {
+        if(root == nullptr) initTree();
+    }
+
     void deleteKey(const key_type& key) {
         Node *delNode = findKey(key);
         if(delNode == nullptr)
             throw std::out_of_range("No such an element");
 
-        if(root->value.first == key && size == 1) {
+        if(delNode == root && size == 1) {
             root = root->parent;
             delete root->left;
             root->left = nullptr;
+            thread(nullptr, root);
+            leftmost = root;
+            rightmost = nullptr;
             --size;
-        } else if(delNode->left != nullptr && delNode->right != nullptr) {
+            return;
+        }
+
+        if(delNode == leftmost) leftmost = Links::next(delNode);
+        if(delNode == rightmost) rightmost = Links::prev(delNode);
+        Links::detached(delNode);
+
+        Node *parent, *child;
+        bool fromLeft;
+        int state = delNode->height;
+        if(delNode->left != nullptr && delNode->right != nullptr) {
             Node *successor = delNode->right;
             while(successor->left != nullptr)
                 successor = successor->left;
 
-            Node *tmp = delNode;
-            delNode = new Node(successor->value.first, successor->value.second);
-                delNode->parent = tmp->parent;
-                delNode->left = tmp->left;
-                delNode->right = tmp->right;
-                if(root == tmp) root = delNode;
+            // successor takes over the place and state of delNode, its own slot is the one removed
+            state = successor->height;
+            child = successor->right;
+            if(successor->parent != delNode) {
+                parent = successor->parent;
+                fromLeft = true;
+                parent->left = child;
+                if(child != nullptr)
+                    child->parent = parent;
+
+                successor->right = delNode->right;
+                successor->right->parent = successor;
+            } else {
+                parent = successor;
+                fromLeft = false;
+            }
 
-            if(tmp->parent->left == tmp)
-                tmp->parent->left = delNode;
-            else tmp->parent->right = delNode;
-            delete delNode;
+            successor->left = delNode->left;
+            successor->left->parent = successor;
+            successor->parent = delNode->parent;
+            successor->height = delNode->height;
 
-            if(successor->right != nullptr)
-                successor->right->parent = successor->parent;
+            if(delNode->parent->left == delNode)
+                delNode->parent->left = successor;
+            else delNode->parent->right = successor;
+
+            if(delNode == root) root = successor;
+        } else {
+            child = delNode->left != nullptr ? delNode->left : delNode->right;
+            parent = delNode->parent;
+            fromLeft = parent->left == delNode;
+            if(child != nullptr)
+                child->parent = parent;
+
+            if(fromLeft)
+                parent->left = child;
+            else parent->right = child;
+
+            if(delNode == root) root = child;
+        }
 
-            if(successor->parent->left == successor)
-                successor->parent->left = successor->right;
-            else successor->parent->right = successor->right;
+        delete delNode;
+        --size;
+        if(Node* top = Balance::erased(parent, child, fromLeft, state)) root = top;
+    }
 
-            if(successor->parent->parent != nullptr) rebalance(successor->parent);
-            delete successor;
-            --size;
-        } else if(delNode->left != nullptr && delNode->right == nullptr) {
-            delNode->left->parent = delNode->parent;
+    void splitOff(const key_type& key, BalancedTree& other) {
+        Node* bound = lowerBound(key);
+        if(size == 0 || bound->parent == nullptr) return;
 
-            if(delNode->parent->left == delNode)
-                delNode->parent->left = delNode->left;
-            else delNode->parent->right = delNode->left;
+        Node *first = leftmost, *last = rightmost, *before = Links::prev(bound);
+        expose(bound);
+        size_type oldSize = size;
+        Node *left, *found, *right;
+        split(detach(), key, left, found, right);
+        right = join(nullptr, found, right);
 
-            if(delNode == root) root = delNode->left;
-            if(delNode->parent->parent != nullptr) rebalance(delNode->parent);
-            delete delNode;
-            --size;
-        } else if(delNode->left == nullptr && delNode->right != nullptr) {
-            delNode->right->parent = delNode->parent;
+        size_type moved = countNodes(right);
+        adopt(left, oldSize - moved, first, before);
+        other.adopt(right, moved, bound, last);
+    }
 
-            if(delNode->parent->left == delNode)
-                delNode->parent->left = delNode->right;
-            else delNode->parent->right = delNode->right;
+    void eraseRange(const key_type& lo, const key_type& hi) {
+        if(size == 0 || !compare(lo, hi)) return;
 
-            if(delNode == root) root = delNode->right;
-            if(delNode->parent->parent != nullptr)  rebalance(delNode->parent);
-            delete delNode;
-            --size;
-        } else { //leaf
-             if(delNode->parent->left == delNode)
-                delNode->parent->left = nullptr;
-            else delNode->parent->right = nullptr;
+        Node *first, *last;
+        size_type erased;
+        deleteNode(cutRange(lo, hi, erased, first, last));
+    }
 
-            if(delNode->parent->parent != nullptr) rebalance(delNode->parent);
-            delete delNode;
-            --size;
-        }
+    void extractRange(const key_type& lo, const key_type& hi, BalancedTree& other) {
+        if(size == 0 || !compare(lo, hi)) return;
+
+        Node *first, *last;
+        size_type moved;
+        Node* middle = cutRange(lo, hi, moved, first, last);
+        other.adopt(middle, moved, first, last);
+    }
+
+    // succeeds only when all keys of one tree are less than all keys of the other
+    bool joinDisjoint(BalancedTree& other) {
+        if(other.size == 0) return true;
+        ensureGuard();
+
+        size_type joinedSize = size + other.size;
+        Node *first = leftmost, *last = rightmost, *otherFirst = other.leftmost, *otherLast = other.rightmost;
+        if(size == 0)
+            adopt(other.detach(), joinedSize, otherFirst, otherLast);
+        else if(compare(last->value.first, otherFirst->value.first)) {
+            expose(getLastNode());
+            other.expose(otherFirst);
+            adopt(join(detach(), nullptr, other.detach()), joinedSize, first, otherLast);
+            thread(last, otherFirst);
+        } else if(compare(otherLast->value.first, first->value.first)) {
+            other.expose(other.getLastNode());
+            expose(first);
+            adopt(join(other.detach(), nullptr, detach()), joinedSize, otherFirst, last);
+            thread(otherLast, first);
+        } else return false;
+
+        return true;
+    }
 
+    void unionWith(const BalancedTree& other) {
+        if(other.size == 0) return;
+        ensureGuard();
+
+        limitDepth();
+        other.limitDepth();
+        size_type oldSize = size;
+        size_type added = 0;
+        Node* united = unite(detach(), other.root, added, forkDepth());
+        adopt(united, oldSize + added);
+    }
+
+    // nodes of other are spliced in or freed, leaving it empty
+    void unionWith(BalancedTree&& other) {
+        if(other.size == 0) return;
+        ensureGuard();
+
+        limitDepth();
+        other.limitDepth();
+        size_type oldSize = size;
+        size_type added = 0;
+        Node* united = uniteMoved(detach(), other.detach(), added, forkDepth());
+        adopt(united, oldSize + added);
     }
 
-    ~AVLTree() {
+    void intersectWith(const BalancedTree& other) {
+        if(size == 0) return;
+
+        limitDepth();
+        other.limitDepth();
+        size_type oldSize = size;
+        size_type removed = 0;
+        Node* common = intersect(detach(), other.size == 0 ? nullptr : other.root, removed, forkDepth());
+        adopt(common, oldSize - removed);
+    }
+
+    void differenceWith(const BalancedTree& other) {
+        if(size == 0 || other.size == 0) return;
+
+        limitDepth();
+        other.limitDepth();
+        size_type oldSize = size;
+        size_type removed = 0;
+        Node* rest = subtract(detach(), other.root, removed, forkDepth());
+        adopt(rest, oldSize - removed);
+    }
+
+    ~BalancedTree() {
         clear();
     }
 
 private:
-    int height(Node* node) {
+    struct StopAtMatch
+    {};
+
+    template <typename Key>
+    using Descent = typename std::conditional<ThreeWayCompare<Compare, Key, key_type>::value || !Balance::selfAdjusting,
+                                              ThreeWayCompare<Compare, Key, key_type>, StopAtMatch>::type;
+
+    // one three-way comparison per level, stops at the match;
+    // otherwise parent and asLeft tell where key would be attached
+    template <typename Key>
+    Node* locate(const Key& key, Node*& parent, bool& asLeft, std::true_type) const {
+        using Order = ThreeWayCompare<Compare, Key, key_type>;
+
+        Node* current = root;
+        while(current != nullptr) {
+            int order = Order::compare(key, current->value.first);
+            if(order == 0) return current;
+
+            parent = current;
+            asLeft = order < 0;
+            current = asLeft ? current->left : current->right;
+        }
+
+        return nullptr;
+    }
+
+    // one Compare call per level, equality is checked once against the lowest candidate
+    template <typename Key>
+    Node* locate(const Key& key, Node*& parent, bool& asLeft, std::false_type) const {
+        Node* current = root;
+        Node* bound = nullptr;
+        while(current != nullptr) {
+            parent = current;
+            asLeft = !compare(current->value.first, key);
+            if(asLeft) bound = current;
+            current = asLeft ? current->left : current->right;
+        }
+
+        if(bound != nullptr && !compare(key, bound->value.first)) return bound;
+        return nullptr;
+    }
+
+    // two Compare calls per level, but splayed hits are found right at the root
+    template <typename Key>
+    Node* locate(const Key& key, Node*& parent, bool& asLeft, StopAtMatch) const {
+        Node* current = root;
+        while(current != nullptr) {
+            if(compare(key, current->value.first))
+                asLeft = true;
+            else if(compare(current->value.first, key))
+                asLeft = false;
+            else return current;
+
+            parent = current;
+            current = asLeft ? current->left : current->right;
+        }
+
+        return nullptr;
+    }
+
+    Node* attach(Node* parent, bool asLeft, const key_type& key, mapped_type& mapped_value) {
+        Node* created = new Node(key, mapped_value);
+        Balance::created(created);
+        created->parent = parent;
+
+        if(asLeft) {
+            parent->left = created;
+            if(parent == leftmost) leftmost = created;
+        } else {
+            parent->right = created;
+            if(parent == rightmost) rightmost = created;
+        }
+        Links::attached(created);
+
+        ++size;
+        if(Node* top = Balance::inserted(created)) root = top;
+        return created;
+    }
+
+    Node* accessed(Node* node) const {
+        if(Node* top = Balance::accessed(node)) root = top;
+        return node;
+    }
+
+    // splits and joins recurse along the search path of their key. A self-adjusting tree gets
+    // the predecessor of bound and then bound itself splayed to the root, which leaves the predecessor
+    // as the root's left child without a right one, so the path is at most two levels long;
+    // bound may be the guard. Other trees without depth bound are rebuilt.
+    void expose(Node* bound) const {
+        if(!Balance::selfAdjusting) {
+            limitDepth();
+            return;
+        }
+
+        if(Node* previous = Links::prev(bound)) accessed(previous);
+        if(bound->parent != nullptr) accessed(bound);
+    }
+
+    // takes keys in [lo, hi) out as a tree with count nodes from first to last; the rest stays here, threaded.
+    // The tree is cut at lo and then at hi, each bound looked up and exposed right before its cut.
+    Node* cutRange(const key_type& lo, const key_type& hi, size_type& count, Node*& first, Node*& last) {
+        Node* low = lowerBound(lo);
+        count = 0;
+        if(low->parent == nullptr || !compare(low->value.first, hi)) return nullptr;
+
+        Node *oldFirst = leftmost, *oldLast = rightmost, *before = Links::prev(low);
+        size_type oldSize = size;
+        Node *left, *middle, *right, *lowFound, *highFound;
+        expose(low);
+        split(detach(), lo, left, lowFound, middle);
+        adopt(join(nullptr, lowFound, middle), oldSize, low, oldLast);
+
+        Node* high = lowerBound(hi);
+        bool highIsEnd = high->parent == nullptr;
+        first = low;
+        last = Links::prev(high);
+        expose(high);
+        split(detach(), hi, middle, highFound, right);
+        count = countNodes(middle);
+        adopt(join(left, highFound, right), oldSize - count,
+              left != nullptr ? oldFirst : high, highIsEnd ? before : oldLast);
+        thread(before, high);
+        return middle;
+    }
+
+    // relinks nodes of a policy without depth bound into a perfectly balanced tree in O(n),
+    // so the recursive set operations below stay within O(log n) stack
+    void limitDepth() const {
+        if(Balance::boundedDepth || size == 0) return;
+
+        Node* guard = root->parent;
+        Node* cursor = Links::threaded ? leftmost : flatten(root);
+        root = build(cursor, size);
+        root->parent = guard;
+        guard->left = root;
+    }
+
+    // without stored links the nodes are first rotated into a list along right links, smallest first
+    static Node* flatten(Node* tree) {
+        Node *first = nullptr, *last = nullptr;
+        while(tree != nullptr) {
+            if(tree->left != nullptr) {
+                Node* left = tree->left;
+                tree->left = left->right;
+                left->right = tree;
+                tree = left;
+            } else {
+                if(last != nullptr) last->right = tree;
+                else first = tree;
+                last = tree;
+                tree = tree->right;
+            }
+        }
+        return first;
+    }
+
+    // each pivot's successor is read before link() overwrites its right link
+    static Node* build(Node*& cursor, size_type count) {
+        if(count == 0) return nullptr;
+
+        Node* left = build(cursor, count / 2);
+        Node* pivot = cursor;
+        cursor = Links::threaded ? Links::next(cursor) : cursor->right;
+        Node* right = build(cursor, count - count / 2 - 1);
+        return link(left, pivot, right);
+    }
+
+    // takes the whole tree out, leaving only the guard
+    Node* detach() {
+        if(size == 0) return nullptr;
+
+        Node* tree = root;
+        root = root->parent;
+        root->left = nullptr;
+        thread(nullptr, root);
+        tree->parent = nullptr;
+        leftmost = root;
+        rightmost = nullptr;
+        size = 0;
+
+        return tree;
+    }
+
+    // hangs tree under the guard of an empty BalancedTree
+    void adopt(Node* tree, size_type count) {
+        if(tree == nullptr) return;
+
+        Node *first = tree, *last = tree;
+        while(first->left != nullptr)
+            first = first->left;
+        while(last->right != nullptr)
+            last = last->right;
+        adopt(tree, count, first, last);
+    }
+
+    // first and last are the known ends of tree, spares walking spines of unbounded depth
+    void adopt(Node* tree, size_type count, Node* first, Node* last) {
+        if(tree == nullptr) return;
+        ensureGuard();
+
+        root->left = tree;
+        tree->parent = root;
+        root = tree;
+        size = count;
+
+        leftmost = first;
+        rightmost = last;
+        thread(nullptr, leftmost);
+        thread(rightmost, tree->parent);
+    }
+
+    // makes a and b in-order neighbours, either may be nullptr
+    static void thread(Node* a, Node* b) {
+        Links::thread(a, b);
+    }
+
+    // links a freshly built subtree in order, previous is the node before it
+    static void threadTree(Node* node, Node*& previous) {
+        if(!Links::threaded || node == nullptr) return;
+
+        threadTree(node->left, previous);
+        thread(previous, node);
+        previous = node;
+        threadTree(node->right, previous);
+    }
+
+    // walks in order by parent links, a split splay tree can still be too deep to recurse
+    static size_type countNodes(Node* node) {
         if(node == nullptr) return 0;
-        return 1 + std::max(height(node->left), height(node->right));
+
+        size_type count = 0;
+        Node* current = node;
+        while(current->left != nullptr)
+            current = current->left;
+        while(true) {
+            ++count;
+            if(current->right != nullptr) {
+                current = current->right;
+                while(current->left != nullptr)
+                    current = current->left;
+                continue;
+            }
+            while(current != node && current == current->parent->right)
+                current = current->parent;
+            if(current == node) return count;
+            current = current->parent;
+        }
     }
 
-    Node* rightRotation(Node* node) {
-        Node* tmp = node->left;
-        tmp->parent = node->parent;
-        node->left = tmp->right;
+    static Node* link(Node* left, Node* pivot, Node* right) {
+        return Balance::link(left, pivot, right);
+    }
 
-        if(tmp->right != nullptr)
-            tmp->right->parent = node;
+    // all keys of left < pivot < all keys of right, pivot may be nullptr
+    static Node* join(Node* left, Node* pivot, Node* right) {
+        if(pivot == nullptr) {
+            if(left == nullptr) return right;
+            if(right == nullptr) return left;
+            left = removeLast(left, pivot);
+        }
 
-        tmp->right = node;
-        node->parent = tmp;
+        return Balance::join(left, pivot, right);
+    }
 
-        if(tmp->parent != nullptr) {
-            if(tmp->parent->right == node)
-                tmp->parent->right = tmp;
-            else tmp->parent->left = tmp;
+    // join for the set operations: pieces come in threaded inside, only the seams
+    // between them and pivot are relinked, so untouched nodes are never visited
+    static Node* joinThreaded(Node* left, Node* pivot, Node* right) {
+        if(!Links::threaded) return join(left, pivot, right);
+
+        Node *last = left, *first = right;
+        while(last != nullptr && last->right != nullptr)
+            last = last->right;
+        while(first != nullptr && first->left != nullptr)
+            first = first->left;
+
+        if(pivot == nullptr)
+            thread(last, first);
+        else {
+            thread(last, pivot);
+            thread(pivot, first);
         }
+        return join(left, pivot, right);
+    }
 
-        return tmp;
+    static Node* removeLast(Node* tree, Node*& last) {
+        if(tree->right == nullptr) {
+            last = tree;
+            return tree->left;
+        }
+
+        Node* rest = removeLast(tree->right, last);
+        return join(tree->left, tree, rest);
     }
 
-    Node* leftRotation(Node* node) {
-        Node* tmp = node->right;
-        tmp->parent = node->parent;
-        node->right = tmp->left;
+    // left gets keys less than key, right gets greater ones
+    void split(Node* tree, const key_type& key, Node*& left, Node*& found, Node*& right) const {
+        if(tree == nullptr) {
+            left = found = right = nullptr;
+            return;
+        }
 
-        if(tmp->left != nullptr)
-            tmp->left->parent = node;
+        if(compare(key, tree->value.first)) {
+            Node* rest = tree->right;
+            split(tree->left, key, left, found, right);
+            right = join(right, tree, rest);
+        } else if(compare(tree->value.first, key)) {
+            Node* rest = tree->left;
+            split(tree->right, key, left, found, right);
+            left = join(rest, tree, left);
+        } else {
+            left = tree->left;
+            right = tree->right;
+            found = link(nullptr, tree, nullptr);
+        }
+    }
 
-        tmp->left = node;
-        node->parent = tmp;
+    // subtrees lower than that are not worth a thread
+    static const int parallelHeight = 12;
+
+    // levels that fork, about log2 of the hardware threads; none on a single core
+    static int forkDepth() {
+        int depth = 0;
+        for(unsigned threads = std::thread::hardware_concurrency(); threads > 1; threads = (threads + 1) >> 1)
+            ++depth;
+        return depth;
+    }
 
-        if(tmp->parent != nullptr) {
-            if(tmp->parent->right == node)
-                tmp->parent->right = tmp;
-            else tmp->parent->left = tmp;
+    static bool worthForking(Node* mine, Node* theirs, int depth) {
+        return depth > 0 && Balance::rank(mine) >= parallelHeight && Balance::rank(theirs) >= parallelHeight;
+    }
+
+    template <typename Left, typename Right>
+    static void forkJoin(bool parallel, Left left, Right right) {
+        if(!parallel) {
+            left();
+            right();
+            return;
         }
 
-        return tmp;
+        std::future<void> pending = std::async(std::launch::async, left);
+        right();
+        pending.get();
     }
 
-    Node* leftRightRotation(Node* node) {
-        node->left = leftRotation(node->left);
-        return rightRotation(node);
+    static Node* copyTree(Node* node) {
+        if(node == nullptr) return nullptr;
+
+        Node* copy = new Node(node->value.first, node->value.second);
+        copy->height = node->height;
+        static_cast<typename Balance::Augment&>(*copy) = *node;
+        copy->left = copyTree(node->left);
+        copy->right = copyTree(node->right);
+
+        if(copy->left != nullptr) copy->left->parent = copy;
+        if(copy->right != nullptr) copy->right->parent = copy;
+        return copy;
     }
 
-    Node* rightLeftRotation(Node* node) {
-        node->right = rightRotation(node->right);
-        return leftRotation(node);
+    // mine is consumed, theirs is only read and copied where needed
+    Node* unite(Node* mine, Node* theirs, size_type& added, int depth) const {
+        if(theirs == nullptr) return mine;
+        if(mine == nullptr) {
+            added += countNodes(theirs);
+            Node* copy = copyTree(theirs);
+            Node* previous = nullptr;
+            threadTree(copy, previous);
+            return copy;
+        }
+
+        bool parallel = worthForking(mine, theirs, depth);
+        Node *left, *found, *right;
+        split(mine, theirs->value.first, left, found, right);
+        if(found == nullptr) {
+            found = new Node(theirs->value.first, theirs->value.second);
+            Balance::created(found);
+            ++added;
+        }
+
+        size_type addedLeft = 0, addedRight = 0;
+        forkJoin(parallel,
+                 [&]() { left = unite(left, theirs->left, addedLeft, depth - 1); },
+                 [&]() { right = unite(right, theirs->right, addedRight, depth - 1); });
+
+        added += addedLeft + addedRight;
+        return joinThreaded(left, found, right);
     }
 
-    void rebalance(Node* node) {
-        if(node == nullptr) return;
-        int balance = height(node->left) - height(node->right);
+    // like unite, but theirs is consumed: its nodes are relinked here or freed when the key is taken
+    Node* uniteMoved(Node* mine, Node* theirs, size_type& added, int depth) const {
+        if(theirs == nullptr) return mine;
+        if(mine == nullptr) {
+            added += countNodes(theirs);
+            return theirs;
+        }
 
-        if(balance == 2) {
-            if(height(node->left->left) >= height(node->left->right))
-                node = rightRotation(node);
-            else node = leftRightRotation(node);
+        bool parallel = worthForking(mine, theirs, depth);
+        Node *theirLeft = theirs->left, *theirRight = theirs->right;
+        Node *left, *found, *right;
+        split(mine, theirs->value.first, left, found, right);
+        if(found == nullptr) {
+            found = link(nullptr, theirs, nullptr);
+            ++added;
+        } else delete theirs;
+
+        size_type addedLeft = 0, addedRight = 0;
+        forkJoin(parallel,
+                 [&]() { left = uniteMoved(left, theirLeft, addedLeft, depth - 1); },
+                 [&]() { right = uniteMoved(right, theirRight, addedRight, depth - 1); });
+
+        added += addedLeft + addedRight;
+        return joinThreaded(left, found, right);
+    }
 
-        } else if(balance == -2) {
-            if(height(node->right->right) >= height(node->right->left))
-                node = leftRotation(node);
-            else node = rightLeftRotation(node);
+    Node* intersect(Node* mine, Node* theirs, size_type& removed, int depth) const {
+        if(mine == nullptr) return nullptr;
+        if(theirs == nullptr) {
+            removed += countNodes(mine);
+            deleteNode(mine);
+            return nullptr;
         }
 
-        if(node->parent->parent != nullptr) rebalance(node->parent);
-        else root = node;
+        bool parallel = worthForking(mine, theirs, depth);
+        Node *left, *found, *right;
+        split(mine, theirs->value.first, left, found, right);
+
+        size_type removedLeft = 0, removedRight = 0;
+        forkJoin(parallel,
+                 [&]() { left = intersect(left, theirs->left, removedLeft, depth - 1); },
+                 [&]() { right = intersect(right, theirs->right, removedRight, depth - 1); });
+
+        removed += removedLeft + removedRight;
+        return joinThreaded(left, found, right);
+    }
+
+    Node* subtract(Node* mine, Node* theirs, size_type& removed, int depth) const {
+        if(mine == nullptr || theirs == nullptr) return mine;
+
+        bool parallel = worthForking(mine, theirs, depth);
+        Node *left, *found, *right;
+        split(mine, theirs->value.first, left, found, right);
+        if(found != nullptr) {
+            delete found;
+            ++removed;
+        }
+
+        size_type removedLeft = 0, removedRight = 0;
+        forkJoin(parallel,
+                 [&]() { left = subtract(left, theirs->left, removedLeft, depth - 1); },
+                 [&]() { right = subtract(right, theirs->right, removedRight, depth - 1); });
+
+        removed += removedLeft + removedRight;
+        return joinThreaded(left, nullptr, right);
     }
 
-    void deleteNode(Node* node) {
-        if(node == nullptr) return;
-        deleteNode(node->left);
-        deleteNode(node->right);
-        delete node;
+    // rotates left children up until the tree becomes a right-leaning list, freeing nodes on the way
+    static void deleteNode(Node* node) {
+        while(node != nullptr) {
+            if(node->left != nullptr) {
+                Node* left = node->left;
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            } else {
+                Node* right = node->right;
+                delete node;
+                node = right;
+            }
+        }
     }
 
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Compare, typename Balance, typename Links>
+class TreeMap<KeyType, ValueType, Compare, Balance, Links>::ConstIterator
 {
+    friend class TreeMap;
+
     Node *current, *begin;
 
 public:
@@ -497,6 +1295,13 @@ public:
     this->begin = other.begin;
   }
 
+  ConstIterator& operator=(const ConstIterator& other)
+  {
+    this->current = other.current;
+    this->begin = other.begin;
+    return *this;
+  }
+
   ConstIterator& operator++()
   {
     if(current == nullptr || begin == nullptr)
@@ -505,20 +1310,7 @@ public:
     if(current->parent == nullptr)
         throw std::out_of_range("No access");
 
-    if(current->right != nullptr) {
-        current = current->right;
-        while(current->left != nullptr)
-            current = current->left;
-
-    } else {
-        Node *parent = current->parent;
-        while(parent->left != current) {
-            current = parent;
-            parent = current->parent;
-        }
-        current = parent;
-    }
-
+    current = Links::next(current);
     return *this;
   }
 
@@ -534,22 +1326,11 @@ public:
     if(current == nullptr || begin == nullptr)
         throw std::out_of_range("No access");
 
-    if(current == begin)
+    Node* previous = current == begin ? nullptr : Links::prev(current);
+    if(previous == nullptr)
         throw std::out_of_range("No access");
 
-    if(current->left != nullptr) {
-        current = current->left;
-        while(current->right != nullptr)
-            current = current->right;
-    } else {
-        Node *parent = current->parent;
-        while(parent->right != current) {
-            current = parent;
-            parent = current->parent;
-        }
-        current = parent;
-    }
-
+    current = previous;
     return *this;
   }
 
@@ -585,8 +1366,8 @@ public:
   }
 };
 
-template <typename KeyType, typename ValueType>
-class TreeMap<KeyType, ValueType>::Iterator : public TreeMap<KeyType, ValueType>::ConstIterator
+template <typename KeyType, typename ValueType, typename Compare, typename Balance, typename Links>
+class TreeMap<KeyType, ValueType, Compare, Balance, Links>::Iterator : public TreeMap<KeyType, ValueType, Compare, Balance, Links>::ConstIterator
 {
 public:
   using reference = typename TreeMap::reference;
@@ -0,0 +1,268 @@
+#ifndef AISDI_MAPS_WORKLOAD_H
+#define AISDI_MAPS_WORKLOAD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace aisdi
+{
+
+enum class WorkloadOperationType
+{
+  Read,
+  Update,
+  Insert,
+  Scan,
+  ReadModifyWrite
+};
+
+enum class KeyDistribution
+{
+  Uniform,
+  Zipfian,
+  Latest,
+  Hotspot
+};
+
+// Share of every operation type and the way their records are chosen, after the YCSB core workloads.
+struct WorkloadSpec
+{
+  const char* name;
+  double read;
+  double update;
+  double insert;
+  double scan;
+  double readModifyWrite;
+  KeyDistribution distribution;
+  double theta;          //Zipfian and Latest skew, in (0, 1)
+  double hotSetFraction; //Hotspot: share of records that are hot
+  double hotOpFraction;  //Hotspot: share of operations on hot records
+  unsigned int maxScanLength;
+
+  static WorkloadSpec ycsbA()
+  {
+    return { "YcsbA", 0.5, 0.5, 0, 0, 0, KeyDistribution::Zipfian, 0.99, 0.2, 0.8, 100 };
+  }
+
+  static WorkloadSpec ycsbB()
+  {
+    return { "YcsbB", 0.95, 0.05, 0, 0, 0, KeyDistribution::Zipfian, 0.99, 0.2, 0.8, 100 };
+  }
+
+  static WorkloadSpec ycsbC()
+  {
+    return { "YcsbC", 1, 0, 0, 0, 0, KeyDistribution::Zipfian, 0.99, 0.2, 0.8, 100 };
+  }
+
+  static WorkloadSpec ycsbD()
+  {
+    return { "YcsbD", 0.95, 0, 0.05, 0, 0, KeyDistribution::Latest, 0.99, 0.2, 0.8, 100 };
+  }
+
+  static WorkloadSpec ycsbE()
+  {
+    return { "YcsbE", 0, 0, 0.05, 0.95, 0, KeyDistribution::Zipfian, 0.99, 0.2, 0.8, 100 };
+  }
+
+  static WorkloadSpec ycsbF()
+  {
+    return { "YcsbF", 0.5, 0, 0, 0, 0.5, KeyDistribution::Zipfian, 0.99, 0.2, 0.8, 100 };
+  }
+};
+
+// Ranks in [0, items) with probability proportional to 1 / (rank + 1)^theta, drawn in O(1)
+// as in Gray et al. "Quickly Generating Billion-Record Synthetic Databases".
+// zeta is extended incrementally when items grows, so Latest keeps up with inserts.
+class ZipfianGenerator
+{
+public:
+  ZipfianGenerator(std::uint64_t items, double theta)
+    : theta(theta), zetan(0), counted(0), etaItems(0), eta(0)
+  {
+    if(!(theta > 0 && theta < 1))
+        throw std::invalid_argument("Zipfian theta must lie in (0, 1)");
+    alpha = 1 / (1 - theta);
+    zeta2 = 1 + std::pow(0.5, theta);
+    grow(items);
+  }
+
+  template <typename Random>
+  std::uint64_t operator()(Random& random, std::uint64_t items)
+  {
+    grow(items);
+    if(etaItems != items) {
+        eta = (1 - std::pow(2.0 / items, 1 - theta)) / (1 - zeta2 / zetan);
+        etaItems = items;
+    }
+
+    const double u = std::generate_canonical<double, 53>(random);
+    const double uz = u * zetan;
+    if(uz < 1)
+        return 0;
+    if(uz < zeta2)
+        return std::min<std::uint64_t>(1, items - 1);
+    const double rank = items * std::pow(eta * u - eta + 1, alpha);
+    return std::min<std::uint64_t>(static_cast<std::uint64_t>(rank), items - 1);
+  }
+
+private:
+    double theta;
+    double alpha;
+    double zeta2;
+    double zetan;
+    std::uint64_t counted;
+    std::uint64_t etaItems;
+    double eta;
+
+    void grow(std::uint64_t items) {
+        for(; counted < items; ++counted)
+            zetan += 1 / std::pow(counted + 1.0, theta);
+    }
+};
+
+struct WorkloadOperation
+{
+  WorkloadOperationType type;
+  std::uint64_t record;
+  unsigned int scanLength;
+};
+
+// Endless, seedable stream of operations over records [0, recordCount); inserts append new records.
+class WorkloadGenerator
+{
+public:
+  WorkloadGenerator(const WorkloadSpec& spec, std::uint64_t recordCount, std::uint64_t seed)
+    : spec(spec), random(seed), zipfian(std::max<std::uint64_t>(1, recordCount), spec.theta),
+      recordCount(recordCount)
+  {
+    total = spec.read + spec.update + spec.insert + spec.scan + spec.readModifyWrite;
+    if(recordCount == 0)
+        throw std::invalid_argument("Workload needs at least one loaded record");
+    if(!(total > 0))
+        throw std::invalid_argument("Workload has no operations");
+  }
+
+  WorkloadOperation next()
+  {
+    double choice = std::generate_canonical<double, 53>(random) * total;
+    WorkloadOperation operation{ WorkloadOperationType::ReadModifyWrite, 0, 0 };
+    if((choice -= spec.read) < 0)
+        operation.type = WorkloadOperationType::Read;
+    else if((choice -= spec.update) < 0)
+        operation.type = WorkloadOperationType::Update;
+    else if((choice -= spec.insert) < 0)
+        operation.type = WorkloadOperationType::Insert;
+    else if((choice -= spec.scan) < 0)
+        operation.type = WorkloadOperationType::Scan;
+
+    if(operation.type == WorkloadOperationType::Insert) {
+        operation.record = recordCount++;
+        return operation;
+    }
+    operation.record = chooseRecord();
+    if(operation.type == WorkloadOperationType::Scan)
+        operation.scanLength = std::uniform_int_distribution<unsigned int>(1, std::max(1u, spec.maxScanLength))(random);
+    return operation;
+  }
+
+  std::uint64_t getRecordCount() const
+  {
+    return recordCount;
+  }
+
+private:
+    WorkloadSpec spec;
+    std::mt19937_64 random;
+    ZipfianGenerator zipfian;
+    std::uint64_t recordCount;
+    double total;
+
+    std::uint64_t uniform(std::uint64_t lo, std::uint64_t hi) {
+        return std::uniform_int_distribution<std::uint64_t>(lo, hi - 1)(random);
+    }
+
+    std::uint64_t chooseRecord() {
+        switch(spec.distribution) {
+        case KeyDistribution::Uniform:
+            return uniform(0, recordCount);
+        case KeyDistribution::Zipfian:
+            //popular ranks are scattered over the records, as in YCSB's scrambled Zipfian
+            return fnv64(zipfian(random, recordCount)) % recordCount;
+        case KeyDistribution::Latest:
+            return recordCount - 1 - zipfian(random, recordCount);
+        case KeyDistribution::Hotspot:
+            break;
+        }
+
+        const std::uint64_t hot = std::min(recordCount, std::max<std::uint64_t>(1, recordCount * spec.hotSetFraction));
+        if(hot == recordCount || std::generate_canonical<double, 53>(random) < spec.hotOpFraction)
+            return uniform(0, hot);
+        return uniform(hot, recordCount);
+    }
+
+    static std::uint64_t fnv64(std::uint64_t value) {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for(int i = 0; i < 8; ++i, value >>= 8)
+            hash = (hash ^ (value & 0xff)) * 0x100000001b3ull;
+        return hash;
+    }
+};
+
+// Record number to key of a given type. int keeps insertion order, 64-bit keys are scattered
+// by a bijective mix, strings vary in length behind a shared "user" prefix like YCSB keys.
+template <typename Key>
+struct WorkloadKey;
+
+template <>
+struct WorkloadKey<int>
+{
+  static const char* name()
+  {
+    return "int";
+  }
+
+  static int make(std::uint64_t record)
+  {
+    return static_cast<int>(record);
+  }
+};
+
+template <>
+struct WorkloadKey<std::uint64_t>
+{
+  static const char* name()
+  {
+    return "u64";
+  }
+
+  // splitmix64 finalizer
+  static std::uint64_t make(std::uint64_t record)
+  {
+    record = (record ^ (record >> 30)) * 0xbf58476d1ce4e5b9ull;
+    record = (record ^ (record >> 27)) * 0x94d049bb133111ebull;
+    return record ^ (record >> 31);
+  }
+};
+
+template <>
+struct WorkloadKey<std::string>
+{
+  static const char* name()
+  {
+    return "string";
+  }
+
+  static std::string make(std::uint64_t record)
+  {
+    const std::uint64_t hash = WorkloadKey<std::uint64_t>::make(record);
+    return "user" + std::to_string(hash) + std::string(hash % 32, 'x');
+  }
+};
+
+} // namespace aisdi
+
+#endif /* AISDI_MAPS_WORKLOAD_H */
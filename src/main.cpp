@@ -1,90 +1,1538 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
 #include <string>
-#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include "TreeMap.h"
 #include "HashMap.h"
+#include "ConcurrentTreeMap.h"
+#include "ShardedTreeMap.h"
+#include "RadixTreeMap.h"
+#include "CompactTreeMap.h"
+#include "AggregateTreeMap.h"
+#include "StdMapAdapter.h"
+#include "Workload.h"
+#include "Trace.h"
+#include "ComplexityFit.h"
+#include "MemoryUsage.h"
+#include "Benchmark.h"
+#include "RegressionGate.h"
 
 #define REPEAT_COUNT 10000
+#define WARMUP_RUNS 2
+#define TRIAL_RUNS 9
+
+// a backend names an engine and instantiates it for given key and value types
+#define BENCHMARK_BACKEND(Backend, label, Engine) \
+    struct Backend { \
+        static const char* name() { return label; } \
+        template <typename K, typename V> using Map = Engine<K, V>; \
+    }
 
 namespace
 {
 
 template <typename K, typename V>
-using Map = aisdi::TreeMap<K, V>;
+using AvlTreeMap = aisdi::TreeMap<K, V, std::less<K>, aisdi::AvlBalance>;
+template <typename K, typename V>
+using RedBlackTreeMap = aisdi::TreeMap<K, V, std::less<K>, aisdi::RedBlackBalance>;
+template <typename K, typename V>
+using TreapTreeMap = aisdi::TreeMap<K, V, std::less<K>, aisdi::TreapBalance>;
+template <typename K, typename V>
+using SplayTreeMap = aisdi::TreeMap<K, V, std::less<K>, aisdi::SplayBalance>;
+template <typename K, typename V>
+using UnthreadedTreeMap = aisdi::TreeMap<K, V, std::less<K>, aisdi::AvlBalance, aisdi::ParentLinks>;
 
-void performTreeMapAdditionTest(unsigned int repeatCount) {
-    aisdi::TreeMap<int, int> collection;
+BENCHMARK_BACKEND(TreeMapBackend, "TreeMap", aisdi::TreeMap);
+BENCHMARK_BACKEND(HashMapBackend, "HashMap", aisdi::HashMap);
+BENCHMARK_BACKEND(StdMapBackend, "std::map", aisdi::StdMap);
+BENCHMARK_BACKEND(StdUnorderedMapBackend, "std::unordered_map", aisdi::StdUnorderedMap);
+#ifdef AISDI_HAS_PMR
+BENCHMARK_BACKEND(PmrStdMapBackend, "pmr::map", aisdi::PmrStdMap);
+BENCHMARK_BACKEND(PmrStdUnorderedMapBackend, "pmr::unordered_map", aisdi::PmrStdUnorderedMap);
+#endif
+BENCHMARK_BACKEND(RadixTreeMapBackend, "RadixTreeMap", aisdi::RadixTreeMap);
+BENCHMARK_BACKEND(CompactTreeMapBackend, "CompactTreeMap", aisdi::CompactTreeMap);
+BENCHMARK_BACKEND(AvlBackend, "AvlTreeMap", AvlTreeMap);
+BENCHMARK_BACKEND(RedBlackBackend, "RedBlackTreeMap", RedBlackTreeMap);
+BENCHMARK_BACKEND(TreapBackend, "TreapTreeMap", TreapTreeMap);
+BENCHMARK_BACKEND(SplayBackend, "SplayTreeMap", SplayTreeMap);
+BENCHMARK_BACKEND(UnthreadedBackend, "UnthreadedTreeMap", UnthreadedTreeMap);
+
+template <typename... Backends>
+struct BackendList
+{
+  template <typename Body>
+  static void forEach(Body body)
+  {
+    const int expand[] = { 0, (body(Backends()), 0)... };
+    (void)expand;
+  }
+};
+
+// full map interface, run through every benchmark
+using MapBackends = BackendList<TreeMapBackend, HashMapBackend, StdMapBackend, StdUnorderedMapBackend
+#ifdef AISDI_HAS_PMR
+                                , PmrStdMapBackend, PmrStdUnorderedMapBackend
+#endif
+                                >;
+// no clear(), so left out of the operation matrix
+using IndexBackends = BackendList<RadixTreeMapBackend, CompactTreeMapBackend>;
+using OrderedBackends = BackendList<TreeMapBackend, StdMapBackend
+#ifdef AISDI_HAS_PMR
+                                    , PmrStdMapBackend
+#endif
+                                    >;
+using BalanceBackends = BackendList<AvlBackend, RedBlackBackend, TreapBackend, SplayBackend, UnthreadedBackend,
+                                    StdMapBackend>;
+
+volatile long long sink; //keeps measured results from being optimized away, stored once per trial
+
+// "--name=value" arguments by name, a bare "--name" meaning "--name=yes", the rest in order
+struct Options {
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> named;
+
+    Options(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            const std::size_t equals = argument.find('=');
+            if (argument.compare(0, 2, "--") != 0 || argument.size() == 2)
+                positional.push_back(argument);
+            else if (equals == std::string::npos)
+                named[argument.substr(2)] = "yes";
+            else
+                named[argument.substr(2, equals - 2)] = argument.substr(equals + 1);
+        }
+    }
 
-    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    // yes/no, true/false, on/off or 1/0; anything else is not a flag
+    bool isFlag(const std::string& name) const {
+        auto it = named.find(name);
+        if (it == named.end())
+            return true;
+        for (const char* value : { "yes", "true", "on", "1", "no", "false", "off", "0" })
+            if (it->second == value)
+                return true;
+        return false;
+    }
 
+    bool flag(const std::string& name, bool fallback) const {
+        auto it = named.find(name);
+        if (it == named.end())
+            return fallback;
+        return it->second == "yes" || it->second == "true" || it->second == "on" || it->second == "1";
+    }
+
+    double number(const std::string& name, double fallback) const {
+        auto it = named.find(name);
+        return it == named.end() ? fallback : std::atof(it->second.c_str());
+    }
+
+    double number(std::size_t index, double fallback) const {
+        return index < positional.size() ? std::atof(positional[index].c_str()) : fallback;
+    }
+
+    std::string text(const std::string& name, const std::string& fallback) const {
+        auto it = named.find(name);
+        return it == named.end() ? fallback : it->second;
+    }
+};
+
+std::vector<int> shuffledKeys(unsigned int repeatCount) {
+    std::vector<int> keys;
     for (std::size_t i = 0; i < repeatCount; ++i)
-        collection[i] = repeatCount - i;
+        keys.push_back(i);
+    std::shuffle(keys.begin(), keys.end(), std::minstd_rand(repeatCount));
+    return keys;
+}
+
+// stored keys are even and misses odd, both visited in shuffled order;
+// collections live on the heap since HashMap keeps its 64000 buckets inline
+template <typename Backend>
+void performOperationMatrix(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    using Collection = typename Backend::template Map<int, int>;
+    const std::string name = Backend::name();
 
-    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    std::vector<int> hits, misses;
+    for (int key : shuffledKeys(repeatCount)) {
+        hits.push_back(2 * key);
+        misses.push_back(2 * key + 1);
+    }
+    auto filled = [&]() {
+        std::unique_ptr<Collection> collection(new Collection);
+        for (int key : hits)
+            (*collection)[key] = key;
+        return collection;
+    };
+    const std::unique_ptr<Collection> source = filled();
+    const Collection& stored = *source;
+    const std::size_t count = hits.size();
 
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-    std::cout<<"[ TreeMapAddition ]\t\t" << duration <<" [ms]"<<std::endl;
+    benchmark.run(name, "Insert", count, [&]() {
+        std::unique_ptr<Collection> collection(new Collection);
+        return aisdi::Benchmark::time([&]() {
+            for (int key : hits)
+                (*collection)[key] = key;
+        });
+    });
+    benchmark.run(name, "HitLookup", count, [&]() {
+        const auto last = stored.end();
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (int key : hits)
+                sum += stored.find(key) != last;
+            sink = sum;
+        });
+    });
+    benchmark.run(name, "MissLookup", count, [&]() {
+        const auto last = stored.end();
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (int key : misses)
+                sum += stored.find(key) != last;
+            sink = sum;
+        });
+    });
+    benchmark.run(name, "ValueOf", count, [&]() {
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (int key : hits)
+                sum += stored.valueOf(key);
+            sink = sum;
+        });
+    });
+    benchmark.run(name, "Remove", count, [&]() {
+        std::unique_ptr<Collection> collection = filled();
+        return aisdi::Benchmark::time([&]() {
+            for (int key : hits)
+                collection->remove(key);
+        });
+    });
+    benchmark.run(name, "Copy", count, [&]() {
+        std::unique_ptr<Collection> copy;
+        return aisdi::Benchmark::time([&]() {
+            copy.reset(new Collection(stored));
+        });
+    });
+    // a single operation: moving does not depend on the item count
+    benchmark.run(name, "Move", 1, [&]() {
+        std::unique_ptr<Collection> collection = filled(), moved;
+        return aisdi::Benchmark::time([&]() {
+            moved.reset(new Collection(std::move(*collection)));
+        });
+    });
+    benchmark.run(name, "Iteration", count, [&]() {
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (auto it = stored.begin(), last = stored.end(); it != last; ++it)
+                sum += it->second;
+            sink = sum;
+        });
+    });
+    benchmark.run(name, "Clear", count, [&]() {
+        std::unique_ptr<Collection> collection = filled();
+        return aisdi::Benchmark::time([&]() {
+            collection->clear();
+        });
+    });
 }
 
-void performHashMapAdditionTest(unsigned int repeatCount) {
-    aisdi::HashMap<int, int> collection;
+// long shared prefixes make every comparison walk most of the key
+std::string urlKey(int i) {
+    return "https://example.com/catalogue/items/" + std::to_string(i);
+}
 
-    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+// looks up every key once in given order
+template <typename Collection, typename Key>
+void performLookupTest(aisdi::Benchmark& benchmark, const Collection& collection, const std::vector<Key>& keys,
+                       const std::string& engine, const std::string& operation) {
+    benchmark.run(engine, operation, keys.size(), [&]() {
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (const Key& key : keys)
+                sum += collection.valueOf(key);
+            sink = sum;
+        });
+    });
+}
 
+template <typename Backend>
+void performIntLookupTest(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    std::unique_ptr<typename Backend::template Map<int, int>> collection(new typename Backend::template Map<int, int>);
     for (std::size_t i = 0; i < repeatCount; ++i)
-        collection[i] = repeatCount - i;
-
-    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+        (*collection)[i] = repeatCount - i;
 
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-    std::cout<<"[ HashMapAddition ]\t\t" << duration <<" [ms]"<<std::endl;
+    performLookupTest(benchmark, *collection, shuffledKeys(repeatCount), Backend::name(), "Lookup");
 }
 
-void performTreeMapIterationTest(unsigned int repeatCount) {
+void performFrozenTreeMapLookupTest(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
     aisdi::TreeMap<int, int> collection;
     for (std::size_t i = 0; i < repeatCount; ++i)
         collection[i] = repeatCount - i;
 
-    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    performLookupTest(benchmark, collection.freeze(), shuffledKeys(repeatCount), "FrozenTreeMap", "Lookup");
+}
 
-    for(auto it = collection.cbegin(); it != collection.cend(); ++it) {}
+template <typename Backend>
+void performStringLookupTest(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    std::unique_ptr<typename Backend::template Map<std::string, int>> collection(
+        new typename Backend::template Map<std::string, int>);
+    std::vector<std::string> keys;
+    for (int key : shuffledKeys(repeatCount)) {
+        (*collection)[urlKey(key)] = key;
+        keys.push_back(urlKey(key));
+    }
 
-    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+    performLookupTest(benchmark, *collection, keys, Backend::name(), "StringLookup");
+}
 
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-    std::cout<<"[ TreeMapIteration ]\t\t" << duration <<" [ms]"<<std::endl;
+template <typename Backend>
+void performIterationTest(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    typename Backend::template Map<int, int> collection;
+    for (std::size_t i = 0; i < repeatCount; ++i)
+        collection[i] = repeatCount - i;
+
+    benchmark.run(Backend::name(), "Iteration", collection.getSize(), [&]() {
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for(auto it = collection.cbegin(); it != collection.cend(); ++it)
+                sum += it->second;
+            sink = sum;
+        });
+    });
 }
 
-void performHashMapIterationTest(unsigned int repeatCount) {
-    aisdi::HashMap<int, int> collection;
+// sums values over repeatCount random windows of about 1% of the keys
+template <typename Backend>
+void performRangeSumTest(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    typename Backend::template Map<int, int> collection;
     for (std::size_t i = 0; i < repeatCount; ++i)
         collection[i] = repeatCount - i;
 
-    std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+    const int width = std::max(1u, repeatCount / 100);
+    const std::vector<int> starts = shuffledKeys(repeatCount);
+
+    benchmark.run(Backend::name(), "RangeSum", starts.size(), [&]() {
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (int lo : starts)
+                for (auto it = collection.lower_bound(lo); it != collection.cend() && it->first < lo + width; ++it)
+                    sum += it->second;
+            sink = sum;
+        });
+    });
+}
+
+void performAggregateRangeSumTest(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    aisdi::AggregateTreeMap<int, long long> aggregated;
+    for (std::size_t i = 0; i < repeatCount; ++i)
+        aggregated.insert(i, repeatCount - i);
+
+    const int width = std::max(1u, repeatCount / 100);
+    const std::vector<int> starts = shuffledKeys(repeatCount);
+
+    benchmark.run("AggregateTreeMap", "RangeSum", starts.size(), [&]() {
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (int lo : starts)
+                sum += aggregated.aggregate(lo, lo + width);
+            sink = sum;
+        });
+    });
+}
+
+// repeatCount reads of a YCSB-C stream over records [0, repeatCount), chosen under given distribution
+std::vector<int> workloadKeys(unsigned int repeatCount, aisdi::KeyDistribution distribution) {
+    aisdi::WorkloadSpec spec = aisdi::WorkloadSpec::ycsbC();
+    spec.distribution = distribution;
+    aisdi::WorkloadGenerator generator(spec, std::max(1u, repeatCount), repeatCount);
+    std::vector<int> keys;
+    for (std::size_t i = 0; i < repeatCount; ++i)
+        keys.push_back(aisdi::WorkloadKey<int>::make(generator.next().record));
+    return keys;
+}
+
+// writes: every key inserted, then every present key removed; lookups: every key looked up once in between
+template <typename Backend>
+void performBalanceTest(aisdi::Benchmark& benchmark, const std::vector<int>& keys, const std::string& stream) {
+    using Collection = typename Backend::template Map<int, int>;
+
+    benchmark.run(Backend::name(), stream + "Write", 2 * keys.size(), [&]() {
+        Collection collection;
+        return aisdi::Benchmark::time([&]() {
+            for (int key : keys)
+                collection[key] = key;
+            for (int key : keys)
+                if (collection.contains(key))
+                    collection.remove(key);
+        });
+    });
 
-    for(auto it = collection.begin(); it != collection.end(); ++it) {}
+    Collection collection;
+    for (int key : keys)
+        collection[key] = key;
+    performLookupTest(benchmark, collection, keys, Backend::name(), stream + "Lookup");
+}
+
+void performBalancePolicyTests(aisdi::Benchmark& benchmark, unsigned int repeatCount) {
+    std::vector<int> sequential;
+    for (std::size_t i = 0; i < repeatCount; ++i)
+        sequential.push_back(i);
+
+    const std::pair<const char*, std::vector<int>> streams[] = {
+        { "Uniform", workloadKeys(repeatCount, aisdi::KeyDistribution::Uniform) },
+        { "Sequential", sequential },
+        { "Zipfian", workloadKeys(repeatCount, aisdi::KeyDistribution::Zipfian) },
+    };
+
+    for (const auto& stream : streams)
+        BalanceBackends::forEach([&](auto backend) {
+            performBalanceTest<decltype(backend)>(benchmark, stream.second, stream.first);
+        });
+}
+
+template <typename Collection, typename Key>
+auto scan(const Collection& collection, const Key& key, unsigned int length, int)
+    -> decltype(collection.lower_bound(key), 0LL) {
+    long long sum = 0;
+    auto it = collection.lower_bound(key);
+    for (auto last = collection.cend(); length > 0 && it != last; --length, ++it)
+        sum += it->second;
+    return sum;
+}
 
-    std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+template <typename Collection, typename Key>
+long long scan(const Collection&, const Key&, unsigned int, long) {
+    throw std::logic_error("Scans need an ordered map");
+}
 
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>( t2 - t1 ).count();
-    std::cout<<"[ HashMapIteration ]\t\t" << duration <<" [ms]"<<std::endl;
+// what the operation read, for the caller to sum up
+template <typename Collection, typename Key>
+long long applyOperation(Collection& collection, const aisdi::WorkloadOperation& operation, const Key& key, int value) {
+    switch (operation.type) {
+    case aisdi::WorkloadOperationType::Read:
+        return collection.valueOf(key);
+    case aisdi::WorkloadOperationType::Update:
+    case aisdi::WorkloadOperationType::Insert:
+        collection[key] = value;
+        break;
+    case aisdi::WorkloadOperationType::Scan:
+        return scan(collection, key, operation.scanLength, 0);
+    case aisdi::WorkloadOperationType::ReadModifyWrite:
+        collection[key] = collection.valueOf(key) + value;
+        break;
+    }
+    return 0;
 }
 
+struct WorkloadSettings {
+    std::uint64_t seed;
+    double theta;
+    unsigned int latencyBatch; //operations per latency sample, 0 skips latencies
+};
+
+// operations and their keys are generated up front; every trial loads recordCount records, then runs as many operations
+template <typename Backend, typename Key>
+void performWorkloadTest(aisdi::Benchmark& benchmark, const aisdi::WorkloadSpec& spec, unsigned int recordCount,
+                         const WorkloadSettings& settings) {
+    using Collection = typename Backend::template Map<Key, int>;
+
+    aisdi::WorkloadGenerator generator(spec, std::max(1u, recordCount), settings.seed);
+    std::vector<aisdi::WorkloadOperation> operations;
+    std::vector<Key> loaded, keys;
+    for (std::size_t i = 0; i < recordCount; ++i) {
+        loaded.push_back(aisdi::WorkloadKey<Key>::make(i));
+        operations.push_back(generator.next());
+        keys.push_back(aisdi::WorkloadKey<Key>::make(operations.back().record));
+    }
+
+    const std::string name = std::string(spec.name) + " " + aisdi::WorkloadKey<Key>::name();
+    auto loadedCollection = [&]() {
+        std::unique_ptr<Collection> collection(new Collection);
+        for (std::size_t i = 0; i < loaded.size(); ++i)
+            (*collection)[loaded[i]] = i;
+        return collection;
+    };
+
+    benchmark.run(Backend::name(), name, operations.size(), [&]() {
+        std::unique_ptr<Collection> collection = loadedCollection();
+        return aisdi::Benchmark::time([&]() {
+            long long sum = 0;
+            for (std::size_t i = 0; i < operations.size(); ++i)
+                sum += applyOperation(*collection, operations[i], keys[i], i);
+            sink = sum;
+        });
+    });
+
+    if (settings.latencyBatch == 0)
+        return;
+    // a batch only holds consecutive operations of one type, its mean is recorded once for each of them
+    const std::vector<std::string> types = {
+        name + " Read", name + " Update", name + " Insert", name + " Scan", name + " ReadModifyWrite",
+    };
+    benchmark.runLatency(Backend::name(), types, [&](std::vector<aisdi::LatencyHistogram>& histograms) {
+        std::unique_ptr<Collection> collection = loadedCollection();
+        long long sum = 0;
+        for (std::size_t first = 0, last = 0; first < operations.size(); first = last) {
+            const std::size_t limit = std::min<std::size_t>(operations.size(), first + settings.latencyBatch);
+            for (last = first + 1; last < limit && operations[last].type == operations[first].type; ++last) {}
+
+            const std::uint64_t start = aisdi::LatencyClock::now();
+            for (std::size_t i = first; i < last; ++i)
+                sum += applyOperation(*collection, operations[i], keys[i], i);
+            const std::uint64_t mean = (aisdi::LatencyClock::now() - start) / (last - first);
+            histograms[static_cast<std::size_t>(operations[first].type)].record(mean, last - first);
+        }
+        sink = sum;
+    });
+}
+
+// YCSB A-F with their own distributions, C also under uniform and hotspot choice; E scans, so only ordered engines run it
+template <typename Key>
+void performWorkloadTests(aisdi::Benchmark& benchmark, unsigned int recordCount, const WorkloadSettings& settings) {
+    aisdi::WorkloadSpec uniform = aisdi::WorkloadSpec::ycsbC(), hotspot = aisdi::WorkloadSpec::ycsbC();
+    uniform.name = "YcsbC-Uniform";
+    uniform.distribution = aisdi::KeyDistribution::Uniform;
+    hotspot.name = "YcsbC-Hotspot";
+    hotspot.distribution = aisdi::KeyDistribution::Hotspot;
+
+    aisdi::WorkloadSpec specs[] = {
+        aisdi::WorkloadSpec::ycsbA(), aisdi::WorkloadSpec::ycsbB(), aisdi::WorkloadSpec::ycsbC(),
+        aisdi::WorkloadSpec::ycsbD(), aisdi::WorkloadSpec::ycsbF(), uniform, hotspot,
+    };
+    for (aisdi::WorkloadSpec& spec : specs) {
+        spec.theta = settings.theta;
+        MapBackends::forEach([&](auto backend) {
+            performWorkloadTest<decltype(backend), Key>(benchmark, spec, recordCount, settings);
+        });
+    }
+
+    aisdi::WorkloadSpec scans = aisdi::WorkloadSpec::ycsbE();
+    scans.theta = settings.theta;
+    OrderedBackends::forEach([&](auto backend) {
+        performWorkloadTest<decltype(backend), Key>(benchmark, scans, recordCount, settings);
+    });
+}
+
+template <typename Value>
+struct MemoryValue;
+
+template <>
+struct MemoryValue<int>
+{
+  static const char* name()
+  {
+    return "int";
+  }
+
+  static int make(std::size_t i)
+  {
+    return i;
+  }
+};
+
+// long enough to live on the heap rather than in the small string buffer
+template <>
+struct MemoryValue<std::string>
+{
+  static const char* name()
+  {
+    return "string";
+  }
+
+  static std::string make(std::size_t i)
+  {
+    return std::string(32, 'a' + i % 26);
+  }
+};
+
+double perEntry(double bytes, std::size_t size) {
+    return size == 0 ? 0 : bytes / size;
+}
+
+// fills a map with size entries, then removes every other one; keys and values are built beforehand,
+// so the live bytes are the map's own including the heap parts of its key and value copies;
+// fragmentation is 0 when the map fit into holes the heap already had
+template <typename Backend, typename Key, typename Value>
+void performMemoryTest(std::size_t size) {
+    using Collection = typename Backend::template Map<Key, Value>;
+
+    std::vector<Key> keys;
+    std::vector<Value> values;
+    for (std::size_t i = 0; i < size; ++i) {
+        keys.push_back(aisdi::WorkloadKey<Key>::make(i));
+        values.push_back(MemoryValue<Value>::make(i));
+    }
+
+    aisdi::ProcessMemory::trimHeap();
+    aisdi::AllocationSnapshot::resetPeak();
+    const bool peakResident = aisdi::ProcessMemory::resetPeakResident();
+    const std::uint64_t residentBefore = aisdi::ProcessMemory::residentBytes();
+    const std::uint64_t heapBefore = aisdi::ProcessMemory::heapBytes();
+    const aisdi::AllocationSnapshot before = aisdi::AllocationSnapshot::take();
+
+    std::unique_ptr<Collection> collection(new Collection);
+    for (std::size_t i = 0; i < size; ++i)
+        (*collection)[keys[i]] = values[i];
+    const aisdi::AllocationSnapshot filled = aisdi::AllocationSnapshot::take();
+    const std::uint64_t residentFilled = aisdi::ProcessMemory::residentBytes();
+
+    for (std::size_t i = 0; i < size; i += 2)
+        collection->remove(keys[i]);
+    const aisdi::AllocationSnapshot churned = aisdi::AllocationSnapshot::take();
+    // share of the heap grown for this map that holds no live block after the removals
+    const double heapGrowth = static_cast<double>(aisdi::ProcessMemory::heapBytes()) - heapBefore;
+    const double fragmentation = heapGrowth > 0 ? 1 - std::min(1.0, (churned.liveBytes - before.liveBytes) / heapGrowth) : 0;
+
+    collection.reset();
+    const aisdi::AllocationSnapshot after = aisdi::AllocationSnapshot::take();
+
+    const std::string label = std::string(Backend::name()) + " " + aisdi::WorkloadKey<Key>::name() + "/"
+                              + MemoryValue<Value>::name() + " " + std::to_string(size);
+    std::cout << std::left << std::setw(44) << ("[ " + label + " ]") << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << perEntry(filled.liveBytes - before.liveBytes, size) << " B/entry"
+              << std::setw(7) << std::setprecision(2) << perEntry(filled.allocations - before.allocations, size) << " allocs/entry"
+              << std::setw(9) << churned.frees - filled.frees << " frees"
+              << std::setw(9) << std::setprecision(1) << (filled.peakBytes - before.liveBytes) / 1048576.0 << " MB heap peak"
+              << std::setw(9) << (static_cast<double>(residentFilled) - residentBefore) / 1048576.0 << " MB RSS growth"
+              << std::setw(9) << aisdi::ProcessMemory::peakResidentBytes() / 1048576.0
+              << (peakResident ? " MB RSS peak" : " MB process RSS peak")
+              << std::setw(7) << 100 * fragmentation << "% heap fragmented"
+              << std::setw(9) << after.liveBytes - before.liveBytes << " B left" << std::endl;
+}
+
+template <typename Key, typename Value>
+void performMemoryTests(std::size_t maxSize) {
+    for (std::size_t size = 1000; size <= maxSize; size *= 10) {
+        MapBackends::forEach([&](auto backend) {
+            performMemoryTest<decltype(backend), Key, Value>(size);
+        });
+        IndexBackends::forEach([&](auto backend) {
+            performMemoryTest<decltype(backend), Key, Value>(size);
+        });
+        performMemoryTest<UnthreadedBackend, Key, Value>(size);
+    }
+}
+
+struct SweepSettings {
+    std::size_t maxSize;
+    std::size_t sampleSize;
+    double timeLimit; //seconds a build may be predicted to take before the engine is left out of larger sizes
+};
+
+struct SweepPoint {
+    std::string engine;
+    std::string operation;
+    std::size_t size;
+    double nanoseconds; //per operation
+    double bytesPerEntry;
+};
+
+// 1000 up to maxSize, sqrt(10) apart
+std::vector<std::size_t> sweepSizes(std::size_t maxSize) {
+    std::vector<std::size_t> sizes;
+    for (double size = 1000; size <= maxSize * 1.0001; size *= std::sqrt(10.0))
+        sizes.push_back(std::llround(size));
+    return sizes;
+}
+
+// visits 0..size-1 in scattered order without storing a permutation, large sweeps would not fit it
+class ScatteredOrder {
+public:
+    explicit ScatteredOrder(std::size_t size) : size(size), stride(2654435761u % size) {
+        while (greatestCommonDivisor(stride, size) != 1)
+            ++stride;
+    }
+
+    std::size_t operator[](std::size_t i) const {
+        return (i * stride) % size;
+    }
+
+private:
+    std::size_t size;
+    std::size_t stride;
+
+    static std::size_t greatestCommonDivisor(std::size_t a, std::size_t b) {
+        while (b != 0) {
+            const std::size_t rest = a % b;
+            a = b;
+            b = rest;
+        }
+        return a;
+    }
+};
+
+// at every size the map is built once with even keys, then each operation is timed on a sample of
+// settings.sampleSize keys against the full map, so the rows show the marginal cost at that size;
+// Insert and Remove restore the map untimed; an engine stops once the next size would not fit in
+// memory or its build would take longer than settings.timeLimit
+template <typename Backend>
+void performSweep(aisdi::Benchmark& benchmark, const SweepSettings& settings, std::vector<SweepPoint>& points) {
+    using Collection = typename Backend::template Map<int, int>;
+    const std::string name = Backend::name();
+    std::size_t previousSize = 0;
+    double buildSeconds = 0, bytesPerEntry = 0, insertGrowth = 1, previousInsert = 0;
+
+    for (std::size_t size : sweepSizes(settings.maxSize)) {
+        if (previousSize != 0) {
+            const double available = aisdi::ProcessMemory::availableBytes();
+            const double predicted = buildSeconds * size / previousSize * std::max(1.0, insertGrowth);
+            if (available > 0 && bytesPerEntry * size > 0.8 * available) {
+                std::cout << "[ " << name << " ] stopped before " << size << ": needs about "
+                          << static_cast<long long>(bytesPerEntry * size / 1048576) << " MB" << std::endl;
+                break;
+            }
+            if (predicted > settings.timeLimit) {
+                std::cout << "[ " << name << " ] stopped before " << size << ": build would take about "
+                          << static_cast<long long>(predicted) << " s" << std::endl;
+                break;
+            }
+        }
+
+        const ScatteredOrder order(size);
+        std::unique_ptr<Collection> collection(new Collection);
+        aisdi::allocationCounters().enabled = true;
+        const aisdi::AllocationSnapshot before = aisdi::AllocationSnapshot::take();
+        buildSeconds = aisdi::Benchmark::time([&]() {
+            for (std::size_t i = 0; i < size; ++i) {
+                const int key = 2 * order[i];
+                (*collection)[key] = key;
+            }
+        }) / 1e9;
+        bytesPerEntry = perEntry(aisdi::AllocationSnapshot::take().liveBytes - before.liveBytes, size);
+        aisdi::allocationCounters().enabled = false;
+
+        // stored and added keys are spread evenly over the order, so both are distinct
+        const std::size_t sampleSize = std::max<std::size_t>(1, std::min(size, settings.sampleSize));
+        std::minstd_rand random(size);
+        std::vector<int> hits, misses, stored;
+        for (std::size_t i = 0; i < sampleSize; ++i) {
+            hits.push_back(2 * (random() % size));
+            stored.push_back(2 * order[i * (size / sampleSize)]);
+            misses.push_back(stored.back() + 1);
+        }
+
+        auto record = [&](const std::string& operation, std::size_t operations, auto trial) {
+            const aisdi::BenchmarkResult& result =
+                benchmark.run(name, operation + " " + std::to_string(size), operations, trial);
+            points.push_back({ name, operation, size, result.median, bytesPerEntry });
+            return result.median;
+        };
+        const Collection& map = *collection;
+        record("HitLookup", hits.size(), [&]() {
+            const auto last = map.end();
+            return aisdi::Benchmark::time([&]() {
+                long long sum = 0;
+                for (int key : hits)
+                    sum += map.find(key) != last;
+                sink = sum;
+            });
+        });
+        record("MissLookup", misses.size(), [&]() {
+            const auto last = map.end();
+            return aisdi::Benchmark::time([&]() {
+                long long sum = 0;
+                for (int key : misses)
+                    sum += map.find(key) != last;
+                sink = sum;
+            });
+        });
+        const double insert = record("Insert", misses.size(), [&]() {
+            const double elapsed = aisdi::Benchmark::time([&]() {
+                for (int key : misses)
+                    (*collection)[key] = key;
+            });
+            for (int key : misses)
+                collection->remove(key);
+            return elapsed;
+        });
+        record("Remove", stored.size(), [&]() {
+            const double elapsed = aisdi::Benchmark::time([&]() {
+                for (int key : stored)
+                    collection->remove(key);
+            });
+            for (int key : stored)
+                (*collection)[key] = key;
+            return elapsed;
+        });
+        record("Iteration", size, [&]() {
+            const auto last = map.end();
+            return aisdi::Benchmark::time([&]() {
+                long long sum = 0;
+                for (auto it = map.begin(); it != last; ++it)
+                    sum += it->second;
+                sink = sum;
+            });
+        });
+
+        insertGrowth = previousInsert > 0 ? insert / previousInsert : 1;
+        previousInsert = insert;
+        previousSize = size;
+    }
+}
+
+// growth of every engine's operation cost over the sizes it reached
+void printComplexityEstimates(const std::vector<SweepPoint>& points) {
+    std::vector<std::pair<std::string, std::string>> cases;
+    for (const SweepPoint& point : points)
+        if (std::find(cases.begin(), cases.end(), std::make_pair(point.engine, point.operation)) == cases.end())
+            cases.emplace_back(point.engine, point.operation);
+
+    std::cout << std::endl << "Complexity per operation" << std::endl;
+    for (const auto& sweepCase : cases) {
+        std::vector<double> sizes, costs;
+        for (const SweepPoint& point : points) {
+            if (point.engine == sweepCase.first && point.operation == sweepCase.second && point.nanoseconds > 0) {
+                sizes.push_back(point.size);
+                costs.push_back(point.nanoseconds);
+            }
+        }
+        std::cout << std::left << std::setw(48) << ("[ " + sweepCase.first + " " + sweepCase.second + " ]");
+        if (sizes.size() < 3) {
+            std::cout << "too few sizes" << std::endl;
+            continue;
+        }
+        const aisdi::ComplexityEstimate estimate = aisdi::fitComplexity(sizes, costs);
+        std::cout << std::setw(12) << aisdi::ComplexityEstimate::name(estimate.complexity) << std::right << std::fixed
+                  << "n^" << std::setprecision(2) << estimate.exponent
+                  << "   " << static_cast<std::size_t>(sizes.front()) << ".." << static_cast<std::size_t>(sizes.back())
+                  << std::endl;
+    }
+}
+
+void writeSweepCsv(std::ostream& csv, const std::vector<SweepPoint>& points) {
+    csv << "size,engine,op,ns_per_op,bytes_per_entry" << std::endl << std::fixed << std::setprecision(3);
+    for (const SweepPoint& point : points)
+        csv << point.size << "," << point.engine << "," << point.operation << ","
+            << point.nanoseconds << "," << point.bytesPerEntry << std::endl;
+}
+
+// the operation matrix against a JSON baseline: written when there is none yet or --save is given,
+// otherwise every case is compared and the result is non-zero if any got slower;
+// a baseline measured over other operation counts is refused rather than compared
+int performRegressionGate(const Options& options, unsigned int repeatCount) {
+    const std::string path = options.text("baseline", "baseline.json");
+    const double threshold = options.number("threshold", 0.1);
+    const double significance = options.number("significance", 0.05);
+
+    aisdi::Benchmark benchmark(WARMUP_RUNS, TRIAL_RUNS);
+    MapBackends::forEach([&](auto backend) {
+        performOperationMatrix<decltype(backend)>(benchmark, repeatCount);
+    });
+    IndexBackends::forEach([&](auto backend) {
+        performIterationTest<decltype(backend)>(benchmark, repeatCount);
+    });
+
+    std::ifstream stored(path);
+    if (!stored || options.flag("save", false)) {
+        stored.close();
+        std::ofstream json(path);
+        benchmark.writeJson(json);
+        if (!json) {
+            std::cerr << "Cannot write " << path << std::endl;
+            return 1;
+        }
+        std::cout << std::endl << "Baseline saved to " << path << std::endl;
+        return 0;
+    }
+
+    std::vector<aisdi::BenchmarkResult> baseline;
+    try {
+        baseline = aisdi::Benchmark::readJson(stored);
+    }
+    catch (const std::runtime_error& error) {
+        std::cerr << path << ": " << error.what() << std::endl;
+        return 1;
+    }
+    if (const aisdi::BenchmarkResult* differing = aisdi::differentWorkload(baseline, benchmark.getResults())) {
+        std::cerr << path << ": [ " << differing->engine << " " << differing->operation << " ] was measured over "
+                  << differing->operations << " operations, rerun with the baseline's repeat count or --save"
+                  << std::endl;
+        return 1;
+    }
+
+    const char* verdicts[] = { "", "faster", "SLOWER", "missing", "new" };
+    int slower = 0;
+    std::cout << std::endl << "Against " << path << " (threshold " << 100 * threshold << "%, significance "
+              << significance << ")" << std::endl;
+    for (const aisdi::RegressionCase& compared : aisdi::compareToBaseline(baseline, benchmark.getResults(),
+                                                                          threshold, significance)) {
+        std::cout << std::left << std::setw(48) << ("[ " + compared.engine + " " + compared.operation + " ]")
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << compared.baselineMedian << " ->" << std::setw(10) << compared.currentMedian << " ns/op";
+        if (compared.baselineMedian > 0 && compared.currentMedian > 0)
+            std::cout << std::showpos << std::setw(8) << 100 * (compared.currentMedian / compared.baselineMedian - 1)
+                      << std::noshowpos << "%  p " << std::setprecision(4) << compared.pValue;
+        std::cout << "  " << verdicts[static_cast<int>(compared.verdict)] << std::endl;
+        slower += compared.verdict == aisdi::RegressionVerdict::Slower;
+    }
+    std::cout << slower << " regression(s)" << std::endl;
+    return slower == 0 ? 0 : 1;
+}
+
+const std::vector<std::string> traceOperations = { "Write", "Read", "Find", "Remove", "Clear" };
+
+// operations that failed when recorded (reading or removing a missing key) fail again when replayed;
+// returns what the operation read, for the caller to sum up
+template <typename Collection, typename Key>
+long long applyTraceRecord(Collection& collection, const aisdi::TraceRecord<Key>& record) {
+    try {
+        switch (record.operation) {
+        case aisdi::TraceOperation::Write:
+            collection[record.key] = aisdi::TraceValue<std::string>::make(record.valueSize);
+            break;
+        case aisdi::TraceOperation::Read:
+            return collection.valueOf(record.key).size();
+        case aisdi::TraceOperation::Find:
+            return collection.contains(record.key);
+        case aisdi::TraceOperation::Remove:
+            collection.remove(record.key);
+            break;
+        case aisdi::TraceOperation::Clear:
+            collection.clear();
+            break;
+        }
+    }
+    catch (const std::out_of_range&) {
+        return 1;
+    }
+    return 0;
+}
+
+// nanoseconds the whole replay took; with histograms every operation's latency goes to the one of its kind.
+// Paced replay keeps the recorded gaps and measures from when an operation was due,
+// so time spent behind schedule counts as latency instead of hiding it
+template <typename Collection, typename Key>
+double replayTrace(Collection& collection, const std::vector<aisdi::TraceRecord<Key>>& records, bool paced,
+                   std::vector<aisdi::LatencyHistogram>* histograms) {
+    const double ticksPerNanosecond = 1 / aisdi::LatencyClock::nanosecondsPerTick();
+    return aisdi::Benchmark::time([&]() {
+        const std::uint64_t start = aisdi::LatencyClock::now();
+        double due = 0;
+        long long sum = 0;
+        for (const aisdi::TraceRecord<Key>& record : records) {
+            std::uint64_t begin = aisdi::LatencyClock::now();
+            if (paced) {
+                due += record.delay * ticksPerNanosecond;
+                while (begin - start < due) {
+                    if ((due - (begin - start)) / ticksPerNanosecond > 1e6)
+                        std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    begin = aisdi::LatencyClock::now();
+                }
+                begin = start + static_cast<std::uint64_t>(due);
+            }
+            sum += applyTraceRecord(collection, record);
+            if (histograms != nullptr)
+                (*histograms)[static_cast<std::size_t>(record.operation)].record(aisdi::LatencyClock::now() - begin);
+        }
+        sink = sum;
+    });
+}
+
+template <typename Backend, typename Key>
+void performReplay(aisdi::Benchmark& benchmark, const std::vector<aisdi::TraceRecord<Key>>& records, bool paced) {
+    using Collection = typename Backend::template Map<Key, std::string>;
+    const std::string name = Backend::name();
+    double elapsed = 0;
+
+    if (!paced) {
+        elapsed = benchmark.run(name, "Replay", records.size(), [&]() {
+            std::unique_ptr<Collection> collection(new Collection);
+            return replayTrace(*collection, records, false, nullptr);
+        }).median * records.size();
+    }
+    benchmark.runLatency(name, traceOperations, [&](std::vector<aisdi::LatencyHistogram>& histograms) {
+        std::unique_ptr<Collection> collection(new Collection);
+        const double replayed = replayTrace(*collection, records, paced, &histograms);
+        elapsed = paced ? replayed : elapsed;
+    });
+    std::cout << std::left << std::setw(48) << ("[ " + name + " Throughput ]") << std::right << std::fixed
+              << std::setprecision(0) << std::setw(12) << (elapsed > 0 ? records.size() / elapsed * 1e9 : 0)
+              << " ops/s" << std::endl;
+}
+
+template <typename Key>
+void performReplays(std::istream& input, bool paced) {
+    aisdi::TraceReader<Key> reader(input);
+    std::vector<aisdi::TraceRecord<Key>> records;
+    aisdi::TraceRecord<Key> record;
+    while (reader.next(record))
+        records.push_back(record);
+
+    std::cout << records.size() << " operations, " << (paced ? "recorded pacing" : "full speed") << std::endl;
+    aisdi::Benchmark benchmark(paced ? 0 : WARMUP_RUNS, paced ? 1 : TRIAL_RUNS);
+    MapBackends::forEach([&](auto backend) {
+        performReplay<decltype(backend)>(benchmark, records, paced);
+    });
+}
+
+// a trace replays into maps with string values of the recorded sizes, keyed by the widest type of the recorded kind
+int performTraceReplay(const Options& options) {
+    const std::string path = options.text("trace", "trace.amt");
+    const bool paced = options.text("pacing", "full") == "recorded";
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return 1;
+    }
+    try {
+        const aisdi::TraceKeyKind kind = aisdi::TraceFormat::readKind(input);
+        input.seekg(0);
+        switch (kind) {
+        case aisdi::TraceKeyKind::Signed:
+            performReplays<long long>(input, paced);
+            break;
+        case aisdi::TraceKeyKind::Unsigned:
+            performReplays<std::uint64_t>(input, paced);
+            break;
+        case aisdi::TraceKeyKind::String:
+            performReplays<std::string>(input, paced);
+            break;
+        }
+    }
+    catch (const std::runtime_error& error) {
+        std::cerr << path << ": " << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// a YCSB workload run through a RecordingMap, for trying out replay without a production trace
+int performTraceRecording(const Options& options, unsigned int recordCount, const WorkloadSettings& settings) {
+    const std::string path = options.text("trace", "trace.amt");
+    std::ofstream output(path, std::ios::binary);
+    aisdi::TraceWriter<int> writer(output);
+    aisdi::RecordingMap<aisdi::TreeMap<int, std::string>> map(&writer);
+
+    aisdi::WorkloadSpec spec = aisdi::WorkloadSpec::ycsbA();
+    spec.theta = settings.theta;
+    aisdi::WorkloadGenerator generator(spec, recordCount, settings.seed);
+    for (unsigned int i = 0; i < recordCount; ++i)
+        map[i] = std::string(100, 'v');
+    long long sum = 0;
+    for (unsigned int i = 0; i < 10 * recordCount; ++i) {
+        const aisdi::WorkloadOperation operation = generator.next();
+        if (operation.type == aisdi::WorkloadOperationType::Read)
+            sum += map.valueOf(operation.record).size();
+        else
+            map[operation.record] = std::string(100, 'w');
+    }
+    sink = sum;
+    map.flush();
+
+    if (!output) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return 1;
+    }
+    std::cout << 11 * recordCount << " operations recorded to " << path << std::endl;
+    return 0;
+}
+
+struct ScalingSettings {
+    unsigned int maxThreads;
+    double readShare; //the rest of the operations are inserts and removals in equal parts
+    unsigned int keyRange;
+    unsigned int duration; //milliseconds per run
+    unsigned int trials;
+    bool pin;
+    std::vector<unsigned int> cpus; //thread t is pinned to cpus[t] when pin is set
+};
+
+// CPUs the process may run on, as narrowed by taskset or a cpuset; empty where affinity is unknown
+std::vector<unsigned int> allowedCpus() {
+    std::vector<unsigned int> allowed;
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+        for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &cpus))
+                allowed.push_back(cpu);
+#endif
+    return allowed;
+}
+
+// binds the calling thread to one CPU, false where affinity cannot be set
+bool pinToCpu(unsigned int cpu) {
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// lookups take a shared_timed_mutex shared, a plain mutex exclusively
+template <typename Lock>
+struct ReadGuard {
+    using type = std::lock_guard<Lock>;
+};
+
+template <>
+struct ReadGuard<std::shared_timed_mutex> {
+    using type = std::shared_lock<std::shared_timed_mutex>;
+};
+
+// a single map behind a single lock
+template <typename Backend, typename Lock>
+class LockedScalingTarget {
+public:
+    static std::string name() {
+        return std::string(Backend::name()) + (std::is_same<Lock, std::mutex>::value ? " + mutex" : " + rwlock");
+    }
+
+    void insert(int key) {
+        std::lock_guard<Lock> guard(lock);
+        collection[key] = key;
+    }
+
+    bool contains(int key) const {
+        typename ReadGuard<Lock>::type guard(lock);
+        return collection.contains(key);
+    }
+
+    void remove(int key) {
+        std::lock_guard<Lock> guard(lock);
+        if (collection.contains(key))
+            collection.remove(key);
+    }
+
+private:
+    typename Backend::template Map<int, int> collection;
+    mutable Lock lock;
+};
+
+class ConcurrentScalingTarget {
+public:
+    static std::string name() {
+        return "ConcurrentTreeMap";
+    }
+
+    void insert(int key) {
+        collection.insert(key, key);
+    }
+
+    bool contains(int key) const {
+        return collection.contains(key);
+    }
+
+    void remove(int key) {
+        collection.tryRemove(key);
+    }
+
+private:
+    aisdi::ConcurrentTreeMap<int, int> collection;
+};
+
+// 64 shards split evenly over the key range
+class ShardedScalingTarget {
+public:
+    static std::string name() {
+        return "ShardedTreeMap";
+    }
+
+    explicit ShardedScalingTarget(unsigned int keyRange) : collection(64) {
+        std::vector<int> samples;
+        for (unsigned int i = 0; i < 64; ++i)
+            samples.push_back(static_cast<int>(static_cast<std::uint64_t>(keyRange) * i / 64));
+        collection.reshard(samples);
+    }
+
+    void insert(int key) {
+        collection.insert(key, key);
+    }
+
+    bool contains(int key) const {
+        return collection.contains(key);
+    }
+
+    void remove(int key) {
+        collection.tryRemove(key);
+    }
+
+private:
+    aisdi::ShardedTreeMap<int, int> collection;
+};
+
+template <typename Target>
+std::unique_ptr<Target> makeScalingTarget(unsigned int) {
+    return std::unique_ptr<Target>(new Target);
+}
+
+template <>
+std::unique_ptr<ShardedScalingTarget> makeScalingTarget<ShardedScalingTarget>(unsigned int keyRange) {
+    return std::unique_ptr<ShardedScalingTarget>(new ShardedScalingTarget(keyRange));
+}
+
+struct ScalingRun {
+    double throughput; //operations per second, all threads together
+    double fairness; //Jain's index of the per-thread operation counts, 1 when all are equal
+    double slowest; //fewest operations of a thread relative to the mean
+    unsigned int unpinned; //threads that could not be pinned
+};
+
+// threads are started and pinned first, then all run the mix on target until the duration is over
+template <typename Target>
+ScalingRun runScaling(Target& target, unsigned int threadCount, const ScalingSettings& settings) {
+    std::vector<std::thread> threads;
+    std::vector<std::uint64_t> counts(threadCount);
+    std::vector<long long> found(threadCount); //hits of each thread, published once it stops
+    std::atomic<unsigned int> ready(0), unpinned(0);
+    std::atomic<bool> go(false), stop(false);
+    const unsigned int readLimit = static_cast<unsigned int>(settings.readShare * 1000);
+
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            if (settings.pin && !pinToCpu(settings.cpus[t]))
+                ++unpinned;
+            std::minstd_rand generator(t + 1);
+            std::uint64_t count = 0;
+            long long hits = 0;
+            ++ready;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            while (!stop.load(std::memory_order_relaxed)) {
+                const int key = generator() % settings.keyRange;
+                const unsigned int choice = generator() % 1000;
+                if (choice < readLimit)
+                    hits += target.contains(key);
+                else if (choice % 2 == 0)
+                    target.insert(key);
+                else
+                    target.remove(key);
+                ++count;
+            }
+            counts[t] = count;
+            found[t] = hits;
+        });
+    }
+    while (ready.load() < threadCount)
+        std::this_thread::yield();
+
+    const double elapsed = aisdi::Benchmark::time([&]() {
+        go.store(true, std::memory_order_release);
+        std::this_thread::sleep_for(std::chrono::milliseconds(settings.duration));
+        stop.store(true);
+        for (auto& thread : threads)
+            thread.join();
+    });
+    long long hits = 0;
+    for (long long threadHits : found)
+        hits += threadHits;
+    sink = hits;
+
+    double total = 0, squares = 0, fewest = counts.front();
+    for (double count : counts) {
+        total += count;
+        squares += count * count;
+        fewest = std::min(fewest, count);
+    }
+    return { total / elapsed * 1e9, squares > 0 ? total * total / (threadCount * squares) : 1,
+             total > 0 ? fewest * threadCount / total : 1, unpinned.load() };
+}
+
+// 1, 2, 4, ... threads and maxThreads itself; efficiency is throughput over the single thread one times the threads.
+// Stops with false when a thread could not be pinned, as its numbers would pass for pinned ones.
+template <typename Target>
+bool performScalingTest(const ScalingSettings& settings) {
+    double single = 0;
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < settings.maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(settings.maxThreads);
+
+    for (unsigned int threads : threadCounts) {
+        std::vector<ScalingRun> runs;
+        for (unsigned int trial = 0; trial < settings.trials; ++trial) {
+            std::unique_ptr<Target> target = makeScalingTarget<Target>(settings.keyRange);
+            for (unsigned int key = 0; key < settings.keyRange; key += 2)
+                target->insert(key);
+            runs.push_back(runScaling(*target, threads, settings));
+            if (runs.back().unpinned > 0) {
+                std::cerr << "Could not pin " << runs.back().unpinned << " of " << threads << " threads of "
+                          << Target::name() << ", rerun with --pin=no" << std::endl;
+                return false;
+            }
+        }
+        std::sort(runs.begin(), runs.end(), [](const ScalingRun& a, const ScalingRun& b) {
+            return a.throughput < b.throughput;
+        });
+        const ScalingRun& median = runs[runs.size() / 2];
+        if (threads == 1)
+            single = median.throughput;
+
+        std::cout << std::left << std::setw(44) << ("[ " + Target::name() + " x" + std::to_string(threads) + " ]")
+                  << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(12) << median.throughput << " ops/s"
+                  << std::setprecision(1) << std::setw(8) << (single > 0 ? 100 * median.throughput / (threads * single) : 0)
+                  << "% efficiency" << std::setprecision(3) << std::setw(8) << median.fairness << " fairness"
+                  << std::setprecision(1) << std::setw(7) << 100 * median.slowest << "% slowest thread" << std::endl;
+    }
+    return true;
+}
+
+// pinned runs default to one thread per allowed CPU and never put two threads on one
+int performScalingTests(const Options& options) {
+    const std::vector<unsigned int> cpus = allowedCpus();
+    const unsigned int maxThreads =
+        cpus.empty() ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<unsigned int>(cpus.size());
+    ScalingSettings settings = {
+        static_cast<unsigned int>(options.number("threads", maxThreads)),
+        options.number("reads", 0.9),
+        static_cast<unsigned int>(options.number("keys", 1000000)),
+        static_cast<unsigned int>(options.number("duration", 200)),
+        static_cast<unsigned int>(options.number("trials", 3)),
+        options.flag("pin", true),
+        cpus,
+    };
+    if (settings.maxThreads == 0 || settings.keyRange == 0 || settings.trials == 0
+        || !(settings.readShare >= 0 && settings.readShare <= 1)) {
+        std::cerr << "Scaling needs --threads, --keys and --trials above 0 and --reads in [0, 1]" << std::endl;
+        return 1;
+    }
+    if (settings.pin && settings.maxThreads > settings.cpus.size()) {
+        std::cerr << "Pinning " << settings.maxThreads << " threads needs as many allowed CPUs, the process has "
+                  << settings.cpus.size() << "; lower --threads or pass --pin=no" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Read share " << settings.readShare << ", " << settings.keyRange << " keys, "
+              << (settings.pin ? "pinned" : "unpinned") << " threads" << std::endl;
+    const bool pinned = performScalingTest<LockedScalingTarget<TreeMapBackend, std::mutex>>(settings)
+                        && performScalingTest<LockedScalingTarget<TreeMapBackend, std::shared_timed_mutex>>(settings)
+                        && performScalingTest<LockedScalingTarget<HashMapBackend, std::mutex>>(settings)
+                        && performScalingTest<LockedScalingTarget<HashMapBackend, std::shared_timed_mutex>>(settings)
+                        && performScalingTest<ConcurrentScalingTarget>(settings)
+                        && performScalingTest<ShardedScalingTarget>(settings);
+    return pinned ? 0 : 1;
+}
 
 } // namespace
 
+// every allocation of the benchmark goes through the counters, which only count in memory mode
+void* operator new(std::size_t size)
+{
+  if(void* pointer = aisdi::countedAllocate(size))
+    return pointer;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return aisdi::countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return aisdi::countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  if(void* pointer = aisdi::countedAllocate(size, static_cast<std::size_t>(alignment)))
+    return pointer;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  aisdi::countedFree(pointer);
+}
+#endif
+
 int main(int argc, char** argv)
 {
-  const std::size_t repeatCount = argc > 1 ? std::atoll(argv[1]) : REPEAT_COUNT;
+  const Options options(argc, argv);
+  const std::size_t repeatCount = options.number(0, REPEAT_COUNT);
+  const WorkloadSettings workload = {
+      static_cast<std::uint64_t>(options.number("seed", 1)),
+      options.number("theta", 0.99),
+      static_cast<unsigned int>(options.number("latency-batch", 1)),
+  };
+  aisdi::Benchmark benchmark(WARMUP_RUNS, TRIAL_RUNS);
+
+  if(repeatCount == 0) {
+    std::cerr << "The repeat count must be a number above 0" << std::endl;
+    return 1;
+  }
+  for(const char* name : { "save", "pin", "counters" })
+    if(!options.isFlag(name)) {
+      std::cerr << "--" << name << " takes yes or no" << std::endl;
+      return 1;
+    }
+
+  if(options.text("mode", "time") == "memory") {
+    aisdi::allocationCounters().enabled = true;
+    const std::size_t maxSize = options.number("max-size", 1000000);
+    performMemoryTests<int, int>(maxSize);
+    performMemoryTests<std::uint64_t, std::string>(maxSize);
+    performMemoryTests<std::string, int>(maxSize);
+    return 0;
+  }
+
+  if(options.text("mode", "time") == "record")
+    return performTraceRecording(options, repeatCount, workload);
+  if(options.text("mode", "time") == "replay")
+    return performTraceReplay(options);
+
+  if(options.text("mode", "time") == "scaling")
+    return performScalingTests(options);
+
+  if(options.text("mode", "time") == "regression")
+    return performRegressionGate(options, repeatCount);
+
+  if(options.text("mode", "time") == "sweep") {
+    const SweepSettings settings = {
+        static_cast<std::size_t>(options.number("max-size", 1e8)),
+        static_cast<std::size_t>(options.number("sample", 10000)),
+        options.number("time-limit", 60),
+    };
+    aisdi::Benchmark sweep(1, 5);
+    std::vector<SweepPoint> points;
+    MapBackends::forEach([&](auto backend) {
+        performSweep<decltype(backend)>(sweep, settings, points);
+    });
+    IndexBackends::forEach([&](auto backend) {
+        performSweep<decltype(backend)>(sweep, settings, points);
+    });
+    printComplexityEstimates(points);
+
+    const std::string csvPath = options.text("csv", "sweep.csv");
+    std::ofstream csv(csvPath);
+    writeSweepCsv(csv, points);
+    if(!csv) {
+      std::cerr << "Cannot write " << csvPath << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+    if (options.flag("counters", true) && !aisdi::PerfCounters::instance().open())
+        std::cerr << "Hardware counters unavailable: " << aisdi::PerfCounters::instance().getError() << std::endl;
+
+    MapBackends::forEach([&](auto backend) {
+        performOperationMatrix<decltype(backend)>(benchmark, repeatCount);
+    });
+    IndexBackends::forEach([&](auto backend) {
+        performIterationTest<decltype(backend)>(benchmark, repeatCount);
+    });
+
+    MapBackends::forEach([&](auto backend) {
+        performIntLookupTest<decltype(backend)>(benchmark, repeatCount);
+        performStringLookupTest<decltype(backend)>(benchmark, repeatCount);
+    });
+    IndexBackends::forEach([&](auto backend) {
+        performIntLookupTest<decltype(backend)>(benchmark, repeatCount);
+    });
+    performFrozenTreeMapLookupTest(benchmark, repeatCount);
+
+    OrderedBackends::forEach([&](auto backend) {
+        performRangeSumTest<decltype(backend)>(benchmark, repeatCount);
+    });
+    performAggregateRangeSumTest(benchmark, repeatCount);
+    performBalancePolicyTests(benchmark, repeatCount);
+
+    performWorkloadTests<int>(benchmark, repeatCount, workload);
+    performWorkloadTests<std::uint64_t>(benchmark, repeatCount, workload);
+    performWorkloadTests<std::string>(benchmark, repeatCount, workload);
 
-    performTreeMapAdditionTest(repeatCount);
-    performHashMapAdditionTest(repeatCount);
+    benchmark.compare("std::map");
+    benchmark.compare("std::unordered_map");
+    if (aisdi::PerfCounters::instance().available())
+        benchmark.printCounters();
 
-    performTreeMapIterationTest(repeatCount);
-    performHashMapIterationTest(repeatCount);
+    const std::string jsonPath = options.text("json", "");
+    if (!jsonPath.empty()) {
+        std::ofstream json(jsonPath);
+        benchmark.writeJson(json);
+        if (!json) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+    }
 
   return 0;
 }
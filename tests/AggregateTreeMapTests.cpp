@@ -0,0 +1,218 @@
+#include <AggregateTreeMap.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+namespace
+{
+
+// not commutative, so any fold out of key order shows up
+struct Concatenation
+{
+  std::string identity() const
+  {
+    return std::string();
+  }
+
+  std::string operator()(const std::string& a, const std::string& b) const
+  {
+    return a + b;
+  }
+};
+
+} // namespace
+
+template <typename K>
+using Map = aisdi::AggregateTreeMap<K, std::int64_t>;
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(AggregateTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::int64_t>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+template <typename K>
+std::int64_t sumOfRange(const std::map<K, std::int64_t>& items, K lo, K hi)
+{
+  std::int64_t sum = 0;
+  for (auto it = items.lower_bound(lo); it != items.end() && it->first < hi; ++it)
+    sum += it->second;
+  return sum;
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(0) == map.cend());
+  BOOST_CHECK_EQUAL(map.aggregate(), 0);
+  BOOST_CHECK_EQUAL(map.aggregate(0, 100), 0);
+  BOOST_CHECK_THROW(map.valueOf(0), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenInsertingExistingKey_ThenValueAndSumAreReplaced,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 1, 10 }, { 2, 20 } };
+
+  map.insert(1, 5);
+
+  thenMapContainsItems(map, { { 1, 5 }, { 2, 20 } });
+  BOOST_CHECK_EQUAL(map.aggregate(), 25);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapUnderRandomUpdates_WhenSummingRanges_ThenResultsMatchIteration,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::int64_t> expected;
+  std::mt19937 generator(5);
+
+  for (int i = 0; i < 20000; ++i)
+  {
+    const K key = generator() % 2000;
+    if (generator() % 3 == 0)
+    {
+      if (expected.erase(key) == 1)
+        map.remove(key);
+      else
+        BOOST_CHECK_THROW(map.remove(key), std::out_of_range);
+    }
+    else
+    {
+      map.insert(key, i);
+      expected[key] = i;
+    }
+
+    if (i % 50 == 0)
+    {
+      const K lo = generator() % 2100, hi = generator() % 2100;
+      BOOST_CHECK_EQUAL(map.aggregate(lo, hi), sumOfRange(expected, lo, hi));
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK_EQUAL(map.aggregate(), sumOfRange<K>(expected, 0, 2000));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRangeWithLowNotBelowHigh_WhenAggregating_ThenIdentityIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = { { 1, 10 }, { 2, 20 }, { 3, 30 } };
+
+  BOOST_CHECK_EQUAL(map.aggregate(2, 2), 0);
+  BOOST_CHECK_EQUAL(map.aggregate(3, 1), 0);
+  BOOST_CHECK_EQUAL(map.aggregate(2, 3), 20);
+  BOOST_CHECK_EQUAL(map.aggregate(0, 100), 60);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMinAndMaxMonoids_WhenAggregatingRanges_ThenExtremesAreReturned)
+{
+  aisdi::AggregateTreeMap<int, int, aisdi::MinAggregate<int>> minimum;
+  aisdi::AggregateTreeMap<int, int, aisdi::MaxAggregate<int>> maximum;
+  for (int i = 0; i < 100; ++i)
+  {
+    minimum.insert(i, (i * 37) % 101);
+    maximum.insert(i, (i * 37) % 101);
+  }
+
+  BOOST_CHECK_EQUAL(minimum.aggregate(), 0);
+  BOOST_CHECK_EQUAL(minimum.aggregate(1, 100), 1);
+  BOOST_CHECK_EQUAL(minimum.aggregate(1, 3), 37);
+  BOOST_CHECK_EQUAL(maximum.aggregate(), 100);
+  BOOST_CHECK_EQUAL(maximum.aggregate(1, 3), 74);
+  BOOST_CHECK_EQUAL(minimum.aggregate(50, 50), std::numeric_limits<int>::max());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNonCommutativeMonoid_WhenAggregating_ThenValuesAreCombinedInKeyOrder)
+{
+  aisdi::AggregateTreeMap<int, std::string, Concatenation> map;
+  const std::string letters = "abcdefghijklmnopqrstuvwxyz";
+  for (int i : { 13, 2, 25, 7, 0, 19, 4, 11, 22, 16, 9, 1, 24, 6, 14, 3, 20, 10, 17, 5, 23, 8, 12,
+                 21, 15, 18 })
+    map.insert(i, letters.substr(i, 1));
+
+  BOOST_CHECK_EQUAL(map.aggregate(), letters);
+  BOOST_CHECK_EQUAL(map.aggregate(3, 11), "defghijk");
+
+  map.remove(5);
+  BOOST_CHECK_EQUAL(map.aggregate(3, 11), "deghijk");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenDecrementingFromEnd_ThenItemsAreVisitedBackwards,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 300; ++i)
+    map.insert(i * 2, i);
+
+  auto it = map.cend();
+  for (int i = 299; i >= 0; --i)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, static_cast<K>(i * 2));
+  }
+  BOOST_CHECK(it == map.cbegin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK_EQUAL(map.lower_bound(7)->first, 8);
+  BOOST_CHECK(map.lower_bound(599) == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyingAndMoving_ThenItemsAndSumsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 1, 10 }, { 2, 20 }, { 3, 30 } };
+
+  Map<K> copy = map;
+  BOOST_CHECK(copy == map);
+
+  copy.insert(2, 25);
+  BOOST_CHECK(copy != map);
+  BOOST_CHECK_EQUAL(map.aggregate(), 60);
+
+  Map<K> moved = std::move(copy);
+  BOOST_CHECK(copy.isEmpty());
+  BOOST_CHECK_EQUAL(moved.aggregate(1, 3), 35);
+
+  moved = map;
+  BOOST_CHECK(moved == map);
+
+  moved.remove(moved.find(1));
+  thenMapContainsItems(moved, { { 2, 20 }, { 3, 30 } });
+  BOOST_CHECK_EQUAL(moved.aggregate(), 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
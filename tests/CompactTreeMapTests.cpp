@@ -0,0 +1,179 @@
+#include <CompactTreeMap.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+template <typename K>
+using Map = aisdi::CompactTreeMap<K, std::string>;
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(CompactTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(0) == map.cend());
+  BOOST_CHECK_THROW(map.valueOf(0), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingAndRemovingRandomKeys_ThenMapMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 generator(11);
+
+  for (int i = 0; i < 30000; ++i)
+  {
+    const K key = generator() % 3000;
+    if (generator() % 3 == 0)
+    {
+      if (expected.erase(key) == 1)
+        map.remove(key);
+      else
+        BOOST_CHECK_THROW(map.remove(key), std::out_of_range);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenRemovingItems_ThenFreedSlotsAreReusedByLaterInserts,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = "a";
+
+  const std::string* item = &map.valueOf(500);
+  map.remove(500);
+  map[5000] = "b";
+
+  BOOST_CHECK_EQUAL(&map.valueOf(5000), item);
+  BOOST_CHECK_EQUAL(map.getSize(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenPoolGrows_ThenIteratorsStayValid,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map[0] = "first";
+  auto it = map.find(0);
+
+  for (int i = 1; i < 5000; ++i)
+    map[i] = "x";
+
+  BOOST_CHECK_EQUAL(it->second, "first");
+  BOOST_CHECK_EQUAL((++it)->first, 1);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenReservedMap_WhenInsertingItems_ThenReferencesStayValid,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  map.reserve(5000);
+  std::string& first = map[0];
+
+  for (int i = 1; i < 5000; ++i)
+    map[i] = "x";
+
+  BOOST_CHECK_EQUAL(&map.valueOf(0), &first);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCallingLowerBound_ThenFirstNotLessKeyIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" } };
+  const Map<K> empty;
+
+  BOOST_CHECK_EQUAL(map.lower_bound(5)->first, 10);
+  BOOST_CHECK_EQUAL(map.lower_bound(20)->first, 20);
+  BOOST_CHECK_EQUAL(map.lower_bound(21)->first, 30);
+  BOOST_CHECK(map.lower_bound(31) == map.end());
+  BOOST_CHECK(empty.lower_bound(1) == empty.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenDecrementingFromEnd_ThenItemsAreVisitedBackwards,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 500; ++i)
+    map[i * 3] = std::to_string(i);
+
+  auto it = map.cend();
+  for (int i = 499; i >= 0; --i)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, static_cast<K>(i * 3));
+  }
+  BOOST_CHECK(it == map.cbegin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyingAndMoving_ThenItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 1, "a" }, { 2, "b" }, { 3, "c" } };
+
+  Map<K> copy = map;
+  BOOST_CHECK(copy == map);
+
+  copy.find(2)->second = "d";
+  BOOST_CHECK(copy != map);
+
+  Map<K> moved = std::move(copy);
+  BOOST_CHECK(copy.isEmpty());
+  thenMapContainsItems(moved, { { 1, "a" }, { 2, "d" }, { 3, "c" } });
+
+  moved = map;
+  BOOST_CHECK(moved == map);
+
+  moved.remove(moved.find(1));
+  thenMapContainsItems(moved, { { 2, "b" }, { 3, "c" } });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
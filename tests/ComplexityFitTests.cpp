@@ -0,0 +1,65 @@
+#include <ComplexityFit.h>
+
+#include <cmath>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::Complexity;
+using aisdi::ComplexityEstimate;
+using aisdi::fitComplexity;
+
+BOOST_AUTO_TEST_SUITE(ComplexityFitTests)
+
+std::vector<double> geometricSizes()
+{
+  std::vector<double> sizes;
+  for (double size = 1000; size <= 1e8; size *= std::sqrt(10.0))
+    sizes.push_back(size);
+  return sizes;
+}
+
+std::vector<double> costsOf(Complexity complexity, double coefficient, const std::vector<double>& sizes)
+{
+  std::vector<double> costs;
+  for (std::size_t i = 0; i < sizes.size(); ++i)
+    costs.push_back(coefficient * ComplexityEstimate::model(complexity, sizes[i]) * (i % 2 == 0 ? 1.03 : 0.97));
+  return costs;
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoisyCostsOfEachModel_WhenFitting_ThenThatModelIsChosen)
+{
+  const auto sizes = geometricSizes();
+  for (Complexity complexity : { Complexity::Constant, Complexity::Logarithmic, Complexity::SquareRoot,
+                                 Complexity::Linear, Complexity::Linearithmic, Complexity::Quadratic })
+  {
+    const ComplexityEstimate estimate = fitComplexity(sizes, costsOf(complexity, 5, sizes));
+
+    BOOST_CHECK_EQUAL(ComplexityEstimate::name(estimate.complexity), ComplexityEstimate::name(complexity));
+    BOOST_CHECK_CLOSE(estimate.coefficient, 5, 1);
+    BOOST_CHECK_LT(estimate.error, 0.01);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenPowerLawCosts_WhenFitting_ThenExponentIsTheSlope)
+{
+  const std::vector<double> sizes = { 1e3, 1e4, 1e5, 1e6 };
+  std::vector<double> costs;
+  for (double size : sizes)
+    costs.push_back(2 * std::pow(size, 0.75));
+
+  const ComplexityEstimate estimate = fitComplexity(sizes, costs);
+
+  BOOST_CHECK_CLOSE(estimate.exponent, 0.75, 1e-6);
+  BOOST_CHECK(estimate.complexity == Complexity::SquareRoot || estimate.complexity == Complexity::Linear);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTooFewOrInvalidPoints_WhenFitting_ThenExceptionIsThrown)
+{
+  BOOST_CHECK_THROW(fitComplexity({ 1000 }, { 5 }), std::invalid_argument);
+  BOOST_CHECK_THROW(fitComplexity({ 1000, 2000 }, { 5 }), std::invalid_argument);
+  BOOST_CHECK_THROW(fitComplexity({ 1000, 1000 }, { 5, 6 }), std::invalid_argument);
+  BOOST_CHECK_THROW(fitComplexity({ 1000, 2000 }, { 5, 0 }), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,224 @@
+#include <ConcurrentTreeMap.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+template <typename K>
+using Map = aisdi::ConcurrentTreeMap<K, std::string>;
+
+namespace
+{
+
+struct CountedValue
+{
+  static std::atomic<long> alive;
+
+  CountedValue(int value = 0) : value(value)
+  {
+    ++alive;
+  }
+
+  CountedValue(const CountedValue& other) : value(other.value)
+  {
+    ++alive;
+  }
+
+  ~CountedValue()
+  {
+    --alive;
+  }
+
+  int value;
+};
+
+std::atomic<long> CountedValue::alive(0);
+
+} // namespace
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(ConcurrentTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL((*it).first, item.first);
+    BOOST_CHECK_EQUAL((*it).second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingItems_ThenTheyAreInMapInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  BOOST_CHECK(map.insert(42, "Alice"));
+  BOOST_CHECK(map.insert(27, "Bob"));
+  BOOST_CHECK(!map.insert(42, "Chuck"));
+
+  thenMapContainsItems(map, { { 27, "Bob" }, { 42, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenRemovingItem_ThenItIsNoLongerInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map.remove(42);
+
+  BOOST_CHECK(!map.contains(42));
+  BOOST_CHECK(map.find(42) == map.end());
+  BOOST_CHECK_THROW(map.remove(42), std::out_of_range);
+  BOOST_CHECK(!map.tryRemove(42));
+  BOOST_CHECK(map.tryRemove(27));
+  BOOST_CHECK_THROW(map.valueOf(42), std::out_of_range);
+  map.insert(27, "Bob");
+  thenMapContainsItems(map, { { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenScanningFromLowerBound_ThenFollowingItemsAreVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" }, { 40, "d" } };
+
+  auto it = map.lower_bound(15);
+
+  BOOST_CHECK_EQUAL(it.key(), 20);
+  BOOST_CHECK_EQUAL((*++it).second, "c");
+  BOOST_CHECK_EQUAL((*++it).second, "d");
+  BOOST_CHECK(++it == map.end());
+  BOOST_CHECK(map.lower_bound(41) == map.end());
+  BOOST_CHECK_THROW(*map.end(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenInsertingDisjointKeys_ThenAllItemsAreInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  const int threadCount = 4;
+  const int perThread = 2000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&map, t]() {
+      for (int i = 0; i < perThread; ++i)
+        map.insert(i * threadCount + t, std::to_string(t));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int i = 0; i < perThread * threadCount; ++i)
+    expected[i] = std::to_string(i % threadCount);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenInsertingAndRemovingSameKeys_ThenMapStaysConsistent,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const int threadCount = 4;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; ++t)
+    threads.emplace_back([&map, t]() {
+      for (int i = 0; i < 5000; ++i)
+      {
+        const int key = (i * 7 + t) % 200;
+        if ((i + t) % 3 == 0)
+        {
+          try { map.remove(key); } catch (const std::out_of_range&) {}
+        }
+        else
+          map.insert(key, "x");
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  std::size_t count = 0;
+  K previous{};
+  for (auto it = map.cbegin(); it != map.cend(); ++it, ++count)
+  {
+    if (count > 0)
+      BOOST_CHECK(previous < it.key());
+    previous = it.key();
+    BOOST_CHECK(map.contains(it.key()));
+  }
+  BOOST_CHECK_EQUAL(count, map.getSize());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenChurningKeys_ThenRetiredMemoryIsReclaimed,
+                              K,
+                              TestedKeyTypes)
+{
+  {
+    aisdi::ConcurrentTreeMap<K, CountedValue> map;
+    const int threadCount = 4;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t)
+      threads.emplace_back([&map, t]() {
+        for (int i = 0; i < 50000; ++i)
+        {
+          const int key = (i + t) % 100;
+          if (i % 2 == 0)
+            map.insert(key, CountedValue(i));
+          else
+            map.tryRemove(key);
+        }
+      });
+    for (auto& thread : threads)
+      thread.join();
+
+    // 100000 values were replaced or removed with their nodes, only a few recent ones may wait
+    BOOST_CHECK_LT(CountedValue::alive.load(), 2000);
+    auto it = map.cbegin();
+    for (int i = 0; i < 1000; ++i)
+    {
+      map.insert(i % 100, CountedValue(i));
+      map.tryRemove(i % 100);
+    }
+    // an iterator holds everything retired since it was taken
+    BOOST_CHECK_GE(CountedValue::alive.load(), 1000);
+  }
+
+  BOOST_CHECK_EQUAL(CountedValue::alive.load(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
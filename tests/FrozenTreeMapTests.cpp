@@ -0,0 +1,166 @@
+#include <FrozenTreeMap.h>
+#include <TreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+template <typename K>
+using Map = aisdi::FrozenTreeMap<K, std::string>;
+
+template <typename K>
+using Source = aisdi::TreeMap<K, std::string>;
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(FrozenTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+template <typename K>
+Source<K> sourceWithEvenKeysUpTo(int limit)
+{
+  Source<K> source;
+  for (int i = 0; i < limit; i += 2)
+    source[i] = std::to_string(i);
+  return source;
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyTreeMap_WhenFreezing_ThenFrozenMapIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Source<K> source;
+
+  const Map<K> map = source.freeze();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(0) == map.cend());
+  BOOST_CHECK(map.lower_bound(0) == map.cend());
+  BOOST_CHECK_THROW(map.valueOf(0), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTreeMap_WhenFreezing_ThenFrozenMapIteratesItemsInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  for (int limit = 0; limit < 80; ++limit)
+  {
+    const Source<K> source = sourceWithEvenKeysUpTo<K>(limit);
+    std::map<K, std::string> expected;
+    for (auto&& item : source)
+      expected[item.first] = item.second;
+
+    thenMapContainsItems(source.freeze(), expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenLookingUpKeys_ThenPresentOnesAreFound,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = sourceWithEvenKeysUpTo<K>(200).freeze();
+
+  for (int i = 0; i < 200; ++i)
+  {
+    auto it = map.find(i);
+    if (i % 2 == 0)
+    {
+      BOOST_REQUIRE(it != map.cend());
+      BOOST_CHECK_EQUAL(it->first, static_cast<K>(i));
+      BOOST_CHECK_EQUAL(it->second, std::to_string(i));
+    }
+    else
+    {
+      BOOST_CHECK(it == map.cend());
+      BOOST_CHECK_THROW(map.valueOf(i), std::out_of_range);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenCallingLowerBound_ThenFirstNotLessKeyIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = sourceWithEvenKeysUpTo<K>(101).freeze();
+
+  for (int i = 0; i <= 100; ++i)
+  {
+    auto it = map.lower_bound(i);
+    BOOST_REQUIRE(it != map.cend());
+    BOOST_CHECK_EQUAL(it->first, static_cast<K>(i + i % 2));
+  }
+  BOOST_CHECK(map.lower_bound(101) == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMap_WhenDecrementingFromEnd_ThenItemsAreVisitedBackwards,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = sourceWithEvenKeysUpTo<K>(60).freeze();
+
+  auto it = map.cend();
+  for (int i = 58; i >= 0; i -= 2)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, static_cast<K>(i));
+  }
+  BOOST_CHECK(it == map.cbegin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenIncrementingOrDereferencing_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map = sourceWithEvenKeysUpTo<K>(10).freeze();
+  const Map<K> empty;
+
+  auto it = map.cend();
+  BOOST_CHECK_THROW(++it, std::out_of_range);
+  BOOST_CHECK_THROW(*it, std::out_of_range);
+
+  auto emptyEnd = empty.cend();
+  BOOST_CHECK_THROW(--emptyEnd, std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFrozenMaps_WhenComparing_ThenItemsDecide,
+                              K,
+                              TestedKeyTypes)
+{
+  Source<K> source = sourceWithEvenKeysUpTo<K>(20);
+  const Map<K> map = source.freeze();
+
+  BOOST_CHECK(map == source.freeze());
+
+  source[4] = "other";
+  BOOST_CHECK(map != source.freeze());
+
+  source.remove(4);
+  BOOST_CHECK(map != source.freeze());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
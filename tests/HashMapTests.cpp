@@ -740,6 +740,55 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingItemByIterator_Then
   BOOST_CHECK(map.isEmpty());
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenClearing_ThenMapBecomesEmptyAndReusable,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  map.clear();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(begin(map) == end(map));
+  BOOST_CHECK(map.find(27) == end(map));
+
+  map[27] = "Dave";
+  thenMapContainsItems(map, { { 27, "Dave" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCheckingKeys_ThenOnlyStoredOnesAreContained,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.contains(42));
+  BOOST_CHECK(map.contains(27));
+  BOOST_CHECK(!map.contains(13));
+  BOOST_CHECK(!Map<K>{}.contains(42));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEndIterator_WhenMapChanges_ThenItStillEqualsEnd,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  const auto last = map.end();
+
+  map[42] = "Alice";
+  map[27] = "Bob";
+  BOOST_CHECK(map.end() == last);
+  BOOST_CHECK(map.find(13) == last);
+
+  auto it = map.begin();
+  ++it;
+  ++it;
+  BOOST_CHECK(it == last);
+
+  map.remove(42);
+  BOOST_CHECK(map.end() == last);
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoEmptyMaps_WhenComparingThem_ThenTheyAreReportedAsEqual,
                               K,
                               TestedKeyTypes)
@@ -0,0 +1,95 @@
+#include <LatencyHistogram.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::LatencyHistogram;
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogramTests)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyHistogram_WhenReadingPercentiles_ThenZeroIsReturned)
+{
+  const LatencyHistogram histogram;
+
+  BOOST_CHECK_EQUAL(histogram.getCount(), 0);
+  BOOST_CHECK_EQUAL(histogram.percentile(50), 0);
+  BOOST_CHECK_EQUAL(histogram.min(), 0);
+  BOOST_CHECK_EQUAL(histogram.max(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSmallValues_WhenRecording_ThenTheyAreCountedExactly)
+{
+  LatencyHistogram histogram;
+  for (std::uint64_t value = 1; value <= 100; ++value)
+    histogram.record(value);
+
+  BOOST_CHECK_EQUAL(histogram.getCount(), 100);
+  BOOST_CHECK_EQUAL(histogram.percentile(50), 50);
+  BOOST_CHECK_EQUAL(histogram.percentile(99), 99);
+  BOOST_CHECK_EQUAL(histogram.percentile(100), 100);
+  BOOST_CHECK_EQUAL(histogram.min(), 1);
+  BOOST_CHECK_EQUAL(histogram.max(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(GivenValuesOverWholeRange_WhenReadingPercentiles_ThenRelativeErrorIsBounded)
+{
+  std::mt19937_64 random(3);
+  for (int i = 0; i < 2000; ++i)
+  {
+    const std::uint64_t value = random() >> (random() % 64);
+    LatencyHistogram histogram;
+    histogram.record(value);
+    histogram.record(std::numeric_limits<std::uint64_t>::max());
+
+    const std::uint64_t reported = histogram.percentile(50);
+    BOOST_REQUIRE_GE(reported, value);
+    BOOST_REQUIRE_LE(reported - value, value / 64);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenLongTail_WhenReadingPercentiles_ThenTailIsSeparatedFromMedian)
+{
+  LatencyHistogram histogram;
+  histogram.record(100, 9990);
+  histogram.record(50000, 9);
+  histogram.record(3000000);
+
+  BOOST_CHECK_EQUAL(histogram.percentile(50), 100);
+  BOOST_CHECK_EQUAL(histogram.percentile(99), 100);
+  BOOST_CHECK_CLOSE(static_cast<double>(histogram.percentile(99.95)), 50000, 2);
+  BOOST_CHECK_EQUAL(histogram.percentile(100), 3000000);
+  BOOST_CHECK_EQUAL(histogram.max(), 3000000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoHistograms_WhenMerging_ThenCountsAndExtremesAreCombined)
+{
+  LatencyHistogram first, second, coarse(4);
+  first.record(10, 3);
+  second.record(5);
+  second.record(1000);
+
+  first.merge(second);
+
+  BOOST_CHECK_EQUAL(first.getCount(), 5);
+  BOOST_CHECK_EQUAL(first.min(), 5);
+  BOOST_CHECK_EQUAL(first.max(), 1000);
+  BOOST_CHECK_EQUAL(first.percentile(60), 10);
+  BOOST_CHECK_THROW(first.merge(coarse), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOperation_WhenTimingIt_ThenOneSampleIsRecorded)
+{
+  LatencyHistogram histogram;
+  volatile int sum = 0;
+
+  histogram.time([&]() { for (int i = 0; i < 1000; ++i) sum += i; });
+
+  BOOST_CHECK_EQUAL(histogram.getCount(), 1);
+  BOOST_CHECK_GT(histogram.max(), 0);
+  BOOST_CHECK_GT(aisdi::LatencyClock::nanosecondsPerTick(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
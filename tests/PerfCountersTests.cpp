@@ -0,0 +1,50 @@
+#include <PerfCounters.h>
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::PerfCounters;
+using aisdi::PerfEvent;
+using aisdi::PerfSample;
+
+BOOST_AUTO_TEST_SUITE(PerfCountersTests)
+
+BOOST_AUTO_TEST_CASE(GivenNewSample_WhenReadingIt_ThenNoEventIsCounted)
+{
+  PerfSample sample;
+
+  BOOST_CHECK(sample.empty());
+  BOOST_CHECK(std::isnan(sample[PerfEvent::Cycles]));
+
+  sample[PerfEvent::BranchMisses] = 0;
+  BOOST_CHECK(!sample.empty());
+  BOOST_CHECK_EQUAL(PerfSample::name(static_cast<std::size_t>(PerfEvent::BranchMisses)), "branch-misses");
+}
+
+BOOST_AUTO_TEST_CASE(GivenCounters_WhenCountingRegion_ThenEventsAreReadOrErrorIsReported)
+{
+  PerfCounters& counters = PerfCounters::instance();
+  if (!counters.open())
+  {
+    BOOST_CHECK(!counters.available());
+    BOOST_CHECK(!counters.getError().empty());
+    BOOST_CHECK(counters.read().empty());
+    return;
+  }
+
+  volatile long sum = 0;
+  counters.reset();
+  counters.start();
+  for (int i = 0; i < 100000; ++i)
+    sum += i;
+  counters.stop();
+  const PerfSample counted = counters.read();
+
+  BOOST_CHECK(counters.getError().empty());
+  BOOST_CHECK(!counted.empty());
+  if (!std::isnan(counted[PerfEvent::Instructions]))
+    BOOST_CHECK_GT(counted[PerfEvent::Instructions], 100000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
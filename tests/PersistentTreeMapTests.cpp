@@ -0,0 +1,158 @@
+#include <PersistentTreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+template <typename K>
+using Map = aisdi::PersistentTreeMap<K, std::string>;
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(PersistentTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 0);
+  BOOST_CHECK(map.cbegin() == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingItems_ThenTheyAreInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  map.insert(42, "Alice");
+  map.insert(27, "Bob");
+  map.insert(42, "Chuck");
+
+  thenMapContainsItems(map, { { 27, "Bob" }, { 42, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenReadingOrRemovingMissingKey_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  BOOST_CHECK_THROW(map.valueOf(1), std::out_of_range);
+  BOOST_CHECK_THROW(map.remove(1), std::out_of_range);
+  BOOST_CHECK(map.find(1) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSnapshot_WhenMapIsUpdated_ThenSnapshotIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  const Map<K> snapshot = map.snapshot();
+  map.insert(13, "Chuck");
+  map.insert(42, "Dave");
+  map.remove(27);
+
+  thenMapContainsItems(snapshot, { { 42, "Alice" }, { 27, "Bob" } });
+  thenMapContainsItems(map, { { 13, "Chuck" }, { 42, "Dave" } });
+  BOOST_CHECK(snapshot != map);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenIterator_WhenMapIsUpdated_ThenIteratorWalksOldVersion,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  auto it = map.cbegin();
+  map.remove(42);
+  map.remove(27);
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(it->second, "Bob");
+  BOOST_CHECK_EQUAL((++it)->second, "Alice");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenIteratingBackwards_ThenItemsAreVisitedInReverseOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 50; ++i)
+    map.insert(i, std::to_string(i));
+
+  auto it = map.cend();
+  for (int i = 49; i >= 0; --i)
+    BOOST_CHECK_EQUAL((--it)->first, i);
+
+  BOOST_CHECK(it == map.cbegin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+  BOOST_CHECK_THROW(++map.cend(), std::out_of_range);
+  BOOST_CHECK_THROW(*map.cend(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyVersions_WhenComparingThemWithReference_ThenAllAreIntact,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::vector<Map<K>> versions;
+  std::vector<std::map<K, std::string>> expectedVersions;
+
+  for (int i = 0; i < 300; ++i)
+  {
+    const int key = (i * 37) % 101;
+    if (i % 4 == 3 && expected.count(key))
+    {
+      map.remove(key);
+      expected.erase(key);
+    }
+    else
+    {
+      map.insert(key, std::to_string(i));
+      expected[key] = std::to_string(i);
+    }
+
+    if (i % 30 == 0)
+    {
+      versions.push_back(map.snapshot());
+      expectedVersions.push_back(expected);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+  for (std::size_t i = 0; i < versions.size(); ++i)
+    thenMapContainsItems(versions[i], expectedVersions[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,209 @@
+#include <RadixTreeMap.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+template <typename K>
+using Map = aisdi::RadixTreeMap<K, std::string>;
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(RadixTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.cbegin() == map.cend());
+  BOOST_CHECK(map.find(0) == map.cend());
+  BOOST_CHECK_THROW(map.valueOf(0), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAddingAndRemovingRandomKeys_ThenMapMatchesStdMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  std::mt19937 generator(7);
+
+  for (int i = 0; i < 20000; ++i)
+  {
+    // small key space keeps nodes growing and shrinking through every size
+    const K key = static_cast<K>(generator() % 2000) * 1009;
+    if (generator() % 3 == 0)
+    {
+      if (expected.erase(key) == 1)
+        map.remove(key);
+      else
+        BOOST_CHECK_THROW(map.remove(key), std::out_of_range);
+    }
+    else
+    {
+      map[key] = std::to_string(i);
+      expected[key] = std::to_string(i);
+    }
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSignedKeys_WhenIterating_ThenNegativeKeysGoFirst)
+{
+  Map<std::int32_t> map;
+  std::map<std::int32_t, std::string> expected;
+  for (std::int32_t key : {5, -1, 0, -300000, 70000, -2, 256, -256})
+  {
+    map[key] = std::to_string(key);
+    expected[key] = std::to_string(key);
+  }
+
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeys_WhenIterating_ThenItemsAreInLexicographicOrder)
+{
+  Map<std::string> map;
+  std::map<std::string, std::string> expected;
+  const std::vector<std::string> keys = {"http://a.com/x", "http://a.com", "http://b.org/", "", "a",
+                                         "ab", std::string("a\0b", 3), std::string("a\0", 2),
+                                         "a\xff", "http://a.com/xy", "zz"};
+  for (const auto& key : keys)
+  {
+    map[key] = key;
+    expected[key] = key;
+  }
+
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE(it != map.cend());
+    BOOST_CHECK(it->first == item.first);
+    BOOST_CHECK(map.valueOf(item.first) == item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStringKeys_WhenTakingPrefixRange_ThenOnlyMatchingKeysAreVisited)
+{
+  Map<std::string> map;
+  for (const std::string key : {"http://a.com", "http://a.com/x", "http://a.com/y", "http://a.co",
+                                "http://b.com", "http", "https://a.com"})
+    map[key] = key;
+
+  auto range = map.prefix_range("http://a.com");
+  std::vector<std::string> visited;
+  for (auto it = range.first; it != range.second; ++it)
+    visited.push_back(it->first);
+
+  const std::vector<std::string> expected = {"http://a.com", "http://a.com/x", "http://a.com/y"};
+  BOOST_CHECK(visited == expected);
+
+  range = map.prefix_range("ftp");
+  BOOST_CHECK(range.first == range.second);
+
+  range = map.prefix_range("");
+  BOOST_CHECK(range.first == map.cbegin());
+  BOOST_CHECK(range.second == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCallingLowerBound_ThenFirstNotLessKeyIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 1000; i += 3)
+    map[i] = std::to_string(i);
+
+  for (int i = 0; i <= 999; ++i)
+  {
+    auto it = map.lower_bound(i);
+    BOOST_REQUIRE(it != map.cend());
+    BOOST_CHECK_EQUAL(it->first, static_cast<K>((i + 2) / 3 * 3));
+  }
+  BOOST_CHECK(map.lower_bound(1000) == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenDecrementingFromEnd_ThenItemsAreVisitedBackwards,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  for (int i = 0; i < 600; ++i)
+    map[i * 7] = std::to_string(i);
+
+  auto it = map.cend();
+  for (int i = 599; i >= 0; --i)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, static_cast<K>(i * 7));
+  }
+  BOOST_CHECK(it == map.cbegin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenChangingValueThroughIterator_ThenItIsStored,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = {{1, "a"}, {2, "b"}};
+
+  map.find(2)->second = "c";
+  map.remove(map.find(1));
+
+  thenMapContainsItems(map, {{2, "c"}});
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCopyingAndMoving_ThenItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = {{1, "a"}, {300, "b"}, {70000, "c"}};
+
+  Map<K> copy = map;
+  BOOST_CHECK(copy == map);
+
+  copy[5] = "d";
+  BOOST_CHECK(copy != map);
+
+  Map<K> moved = std::move(copy);
+  BOOST_CHECK(copy.isEmpty());
+  thenMapContainsItems(moved, {{1, "a"}, {5, "d"}, {300, "b"}, {70000, "c"}});
+
+  moved = map;
+  BOOST_CHECK(moved == map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+#include <RegressionGate.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::BenchmarkResult;
+using aisdi::MannWhitney;
+using aisdi::RegressionVerdict;
+
+BOOST_AUTO_TEST_SUITE(RegressionGateTests)
+
+BenchmarkResult resultOf(const std::string& engine, double median, const std::vector<double>& samples)
+{
+  return { engine, "Insert", 100, median, 0, samples, {} };
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeparatedSamples_WhenTesting_ThenExactTailProbabilityIsReturned)
+{
+  const MannWhitney larger = MannWhitney::test({ 1, 2, 3 }, { 4, 5, 6 });
+  const MannWhitney smaller = MannWhitney::test({ 4, 5, 6 }, { 1, 2, 3 });
+
+  BOOST_CHECK_EQUAL(larger.u, 9);
+  BOOST_CHECK_CLOSE(larger.pValue, 1.0 / 20, 1e-9);
+  BOOST_CHECK_EQUAL(smaller.u, 0);
+  BOOST_CHECK_CLOSE(smaller.pValue, 1, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInterleavedSamples_WhenTesting_ThenNoShiftIsFound)
+{
+  const MannWhitney interleaved = MannWhitney::test({ 1, 3, 5, 7, 9 }, { 2, 4, 6, 8, 10 });
+  const MannWhitney tied = MannWhitney::test({ 1, 1, 2, 2, 3, 3 }, { 1, 2, 2, 3, 3, 1 });
+
+  BOOST_CHECK_GT(interleaved.pValue, 0.2);
+  BOOST_CHECK_LT(interleaved.pValue, 0.6);
+  BOOST_CHECK_EQUAL(tied.u, 18);
+  BOOST_CHECK_GT(tied.pValue, 0.4);
+  BOOST_CHECK_CLOSE(MannWhitney::test({}, { 1 }).pValue, 1, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBaselineAndCurrentRun_WhenComparing_ThenOnlySignificantChangesBeyondThresholdCount)
+{
+  const std::vector<double> fast = { 10, 10.1, 10.2, 9.9, 9.8, 10.05, 10.15, 9.95, 10 };
+  const std::vector<double> slow = { 13, 13.1, 13.2, 12.9, 12.8, 13.05, 13.15, 12.95, 13 };
+  const std::vector<double> little = { 10.5, 10.6, 10.7, 10.4, 10.3, 10.55, 10.65, 10.45, 10.5 };
+  const std::vector<BenchmarkResult> baseline = {
+    resultOf("Slower", 10, fast), resultOf("Faster", 13, slow), resultOf("Within", 10, fast),
+    resultOf("Missing", 10, fast) };
+  const std::vector<BenchmarkResult> current = {
+    resultOf("Slower", 13, slow), resultOf("Faster", 10, fast), resultOf("Within", 10.5, little),
+    resultOf("Added", 10, fast) };
+
+  const auto cases = aisdi::compareToBaseline(baseline, current, 0.1, 0.05);
+
+  BOOST_REQUIRE_EQUAL(cases.size(), 5);
+  BOOST_CHECK(cases[0].verdict == RegressionVerdict::Slower);
+  BOOST_CHECK_LT(cases[0].pValue, 0.001);
+  BOOST_CHECK(cases[1].verdict == RegressionVerdict::Faster);
+  BOOST_CHECK(cases[2].verdict == RegressionVerdict::Unchanged);
+  BOOST_CHECK(cases[3].verdict == RegressionVerdict::Missing);
+  BOOST_CHECK(cases[4].verdict == RegressionVerdict::Added);
+  BOOST_CHECK_EQUAL(cases[4].engine, "Added");
+}
+
+BOOST_AUTO_TEST_CASE(GivenBaselineOfOtherSize_WhenCheckingWorkload_ThenDifferingCaseIsReturned)
+{
+  const std::vector<double> samples = { 10, 10.1, 9.9 };
+  const std::vector<BenchmarkResult> baseline = { resultOf("TreeMap", 10, samples), resultOf("HashMap", 10, samples) };
+  std::vector<BenchmarkResult> current = { resultOf("HashMap", 10, samples), resultOf("Added", 10, samples) };
+
+  BOOST_CHECK(aisdi::differentWorkload(baseline, current) == nullptr);
+  current[0].operations = 1000;
+  BOOST_REQUIRE(aisdi::differentWorkload(baseline, current) == &current[0]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBenchmarkResults_WhenWritingAndReadingJson_ThenMediansAndSamplesSurvive)
+{
+  std::ostringstream log;
+  aisdi::Benchmark benchmark(0, 3, log);
+  double next = 1;
+  benchmark.run("Tree\"Map", "Insert", 2, [&]() { return next *= 2; });
+  benchmark.run("HashMap", "Remove", 1, [&]() { return 5.5; });
+
+  std::stringstream json;
+  benchmark.writeJson(json);
+  const auto read = aisdi::Benchmark::readJson(json);
+
+  BOOST_REQUIRE_EQUAL(read.size(), 2);
+  BOOST_CHECK_EQUAL(read[0].engine, "Tree\"Map");
+  BOOST_CHECK_EQUAL(read[0].operation, "Insert");
+  BOOST_CHECK_EQUAL(read[0].operations, 2);
+  BOOST_CHECK_CLOSE(read[0].median, 2, 1e-9);
+  BOOST_REQUIRE_EQUAL(read[0].samples.size(), 3);
+  BOOST_CHECK_CLOSE(read[0].samples[2], 4, 1e-9);
+  BOOST_CHECK_EQUAL(read[1].operation, "Remove");
+  BOOST_CHECK_CLOSE(read[1].median, 5.5, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMalformedJson_WhenReading_ThenExceptionIsThrown)
+{
+  std::istringstream truncated("[{\"engine\": \"TreeMap\", \"samples\": [1, 2");
+  std::istringstream wrong("{\"engine\": 1}");
+
+  BOOST_CHECK_THROW(aisdi::Benchmark::readJson(truncated), std::runtime_error);
+  BOOST_CHECK_THROW(aisdi::Benchmark::readJson(wrong), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,238 @@
+#include <ShardedTreeMap.h>
+
+#include <cstdint>
+#include <string>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/mpl/list.hpp>
+
+template <typename K>
+using Map = aisdi::ShardedTreeMap<K, std::string>;
+
+using TestedKeyTypes = boost::mpl::list<std::int32_t, std::uint64_t>;
+using std::begin;
+using std::end;
+
+BOOST_AUTO_TEST_SUITE(ShardedTreeMapTests)
+
+template <typename K>
+void thenMapContainsItems(const Map<K>& map,
+                          const std::map<K, std::string>& expected)
+{
+  BOOST_CHECK_EQUAL(map.getSize(), expected.size());
+
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_REQUIRE_MESSAGE(it != end(map), "Missing required item with key: " << item.first);
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == end(map));
+}
+
+template <typename K>
+std::vector<K> samplesUpTo(int limit)
+{
+  std::vector<K> samples;
+  for (int i = 0; i < limit; i += 7)
+    samples.push_back(i);
+  return samples;
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCreatedWithDefaultConstructor_ThenItIsEmpty,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map(4);
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK_EQUAL(map.getShardCount(), 1);
+  BOOST_CHECK(map.cbegin() == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingAndRemovingItems_ThenMapReflectsChanges,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map.insert(13, "Chuck");
+  map.insert(42, "Dave");
+  map.remove(27);
+
+  BOOST_CHECK(map.contains(13));
+  BOOST_CHECK(!map.contains(27));
+  BOOST_CHECK_THROW(map.remove(27), std::out_of_range);
+  BOOST_CHECK(!map.tryRemove(27));
+  BOOST_CHECK(map.tryRemove(13));
+  map.insert(13, "Chuck");
+  BOOST_CHECK_THROW(map.valueOf(27), std::out_of_range);
+  thenMapContainsItems(map, { { 13, "Chuck" }, { 42, "Dave" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenFilledMap_WhenResharding_ThenItemsAreKeptInOrderAcrossShards,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(4);
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 500; ++i)
+  {
+    map.insert(i, std::to_string(i));
+    expected[i] = std::to_string(i);
+  }
+
+  map.reshard(samplesUpTo<K>(500));
+
+  BOOST_CHECK_EQUAL(map.getShardCount(), 4);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenShardedMap_WhenScanningRange_ThenItemsFromAllShardsAreVisited,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(4);
+  map.reshard(samplesUpTo<K>(100));
+  for (int i = 0; i < 100; ++i)
+    map.insert(i, std::to_string(i));
+
+  std::vector<K> visited;
+  map.scan(10, 90, [&visited](const std::pair<const K, std::string>& item) {
+    visited.push_back(item.first);
+  });
+
+  BOOST_REQUIRE_EQUAL(visited.size(), 80);
+  for (int i = 0; i < 80; ++i)
+    BOOST_CHECK_EQUAL(visited[i], i + 10);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenUnevenShards_WhenRebalancing_ThenLargeShardsAreSplitAndSmallMerged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(4);
+  std::map<K, std::string> expected;
+  map.reshard(samplesUpTo<K>(100));
+  for (int i = 0; i < 1000; ++i)
+  {
+    map.insert(1000 + i, "x");
+    expected[1000 + i] = "x";
+  }
+
+  map.rebalance();
+
+  BOOST_CHECK_EQUAL(map.getShardCount(), 4);
+  thenMapContainsItems(map, expected);
+}
+
+struct LiveCounted
+{
+  static int live;
+  static int copies;
+
+  LiveCounted() { ++live; }
+  LiveCounted(const LiveCounted&) { ++live; ++copies; }
+  LiveCounted& operator=(const LiveCounted&) = default;
+  ~LiveCounted() { --live; }
+};
+
+int LiveCounted::live = 0;
+int LiveCounted::copies = 0;
+
+BOOST_AUTO_TEST_CASE(GivenIdleMap_WhenReshardingRepeatedly_ThenRetiredLayoutsAreFreed)
+{
+  {
+    aisdi::ShardedTreeMap<int, LiveCounted> map(4);
+    for (int i = 0; i < 100; ++i)
+      map.insert(i, LiveCounted());
+
+    for (int round = 0; round < 100; ++round)
+    {
+      map.reshard(samplesUpTo<int>(100));
+      map.rebalance();
+    }
+
+    // items and the guard of each shard's tree, nothing of the 200 replaced layouts
+    BOOST_CHECK_EQUAL(map.getShardCount(), 4);
+    BOOST_CHECK_LE(LiveCounted::live, 100 + 2 * 4);
+  }
+  BOOST_CHECK_EQUAL(LiveCounted::live, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSkewedMap_WhenReshardingAndRebalancing_ThenNoItemIsCopied)
+{
+  aisdi::ShardedTreeMap<int, LiveCounted> map(8);
+  for (int i = 0; i < 1000; ++i)
+    map.insert(i, LiveCounted());
+  map.reshard(samplesUpTo<int>(100));
+
+  LiveCounted::copies = 0;
+  map.rebalance();
+  map.reshard(samplesUpTo<int>(1000));
+  map.rebalance();
+
+  // only the guard nodes of new shard trees take a copy of a default value
+  BOOST_CHECK_LT(LiveCounted::copies, 100);
+  BOOST_CHECK_EQUAL(map.getShardCount(), 8);
+  BOOST_CHECK_EQUAL(map.getSize(), 1000u);
+  for (int i = 0; i < 1000; ++i)
+    BOOST_CHECK(map.contains(i));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenInsertingDisjointRanges_ThenAllItemsAreInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(4);
+  std::map<K, std::string> expected;
+  map.reshard({ 1000, 2000, 3000 });
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&map, t]() {
+      for (int i = 0; i < 1000; ++i)
+        map.insert(t * 1000 + i, std::to_string(t));
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int i = 0; i < 4000; ++i)
+    expected[i] = std::to_string(i / 1000);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenManyThreads_WhenReshardingWhileInserting_ThenNoItemIsLost,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map(4);
+  std::map<K, std::string> expected;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&map, t]() {
+      for (int i = 0; i < 1000; ++i)
+        map.insert(t * 1000 + i, std::to_string(t));
+    });
+  for (int round = 0; round < 20; ++round)
+  {
+    map.reshard(samplesUpTo<K>(4000));
+    map.rebalance();
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  for (int i = 0; i < 4000; ++i)
+    expected[i] = std::to_string(i / 1000);
+  thenMapContainsItems(map, expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
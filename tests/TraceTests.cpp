@@ -0,0 +1,120 @@
+#include <Trace.h>
+#include <TreeMap.h>
+#include <HashMap.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::RecordingMap;
+using aisdi::TraceOperation;
+using aisdi::TraceReader;
+using aisdi::TraceRecord;
+using aisdi::TraceWriter;
+
+BOOST_AUTO_TEST_SUITE(TraceTests)
+
+template <typename Key>
+std::vector<TraceRecord<Key>> readAll(std::istream& input)
+{
+  TraceReader<Key> reader(input);
+  std::vector<TraceRecord<Key>> records;
+  TraceRecord<Key> record;
+  while (reader.next(record))
+    records.push_back(record);
+  return records;
+}
+
+BOOST_AUTO_TEST_CASE(GivenSignedKeys_WhenWritingAndReadingTrace_ThenRecordsAreEqual)
+{
+  std::stringstream trace;
+  {
+    TraceWriter<long long> writer(trace);
+    writer.record(TraceOperation::Write, -5, 300, 1000);
+    writer.record(TraceOperation::Find, 1LL << 40, 0, 1250);
+    writer.record(TraceOperation::Remove, -(1LL << 62), 0, 1250);
+  }
+
+  const auto records = readAll<long long>(trace);
+
+  BOOST_REQUIRE_EQUAL(records.size(), 3);
+  BOOST_CHECK(records[0].operation == TraceOperation::Write);
+  BOOST_CHECK_EQUAL(records[0].key, -5);
+  BOOST_CHECK_EQUAL(records[0].valueSize, 300);
+  BOOST_CHECK_EQUAL(records[1].key, 1LL << 40);
+  BOOST_CHECK_EQUAL(records[1].delay, 250);
+  BOOST_CHECK(records[2].operation == TraceOperation::Remove);
+  BOOST_CHECK_EQUAL(records[2].key, -(1LL << 62));
+  BOOST_CHECK_EQUAL(records[2].delay, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRecordingTreeMap_WhenUsingIt_ThenOperationsAndValueSizesAreRecorded)
+{
+  std::stringstream trace;
+  {
+    TraceWriter<std::string> writer(trace);
+    RecordingMap<aisdi::TreeMap<std::string, std::string>> map(&writer);
+    map["alpha"] = "12345";
+    map["beta"];
+    BOOST_CHECK_EQUAL(map.valueOf("alpha"), "12345");
+    BOOST_CHECK(map.find("gamma") == map.end());
+    map.remove("beta");
+    BOOST_CHECK_EQUAL(map.getSize(), 1);
+    map.clear();
+    BOOST_CHECK(map.isEmpty());
+  }
+
+  const auto records = readAll<std::string>(trace);
+
+  BOOST_REQUIRE_EQUAL(records.size(), 6);
+  BOOST_CHECK(records[0].operation == TraceOperation::Write);
+  BOOST_CHECK_EQUAL(records[0].key, "alpha");
+  BOOST_CHECK_EQUAL(records[0].valueSize, 5);
+  BOOST_CHECK(records[1].operation == TraceOperation::Write);
+  BOOST_CHECK_EQUAL(records[1].valueSize, 0);
+  BOOST_CHECK(records[2].operation == TraceOperation::Read);
+  BOOST_CHECK(records[3].operation == TraceOperation::Find);
+  BOOST_CHECK_EQUAL(records[3].key, "gamma");
+  BOOST_CHECK(records[4].operation == TraceOperation::Remove);
+  BOOST_CHECK(records[5].operation == TraceOperation::Clear);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRecordingHashMapWithoutTrace_WhenUsingIt_ThenItOnlyForwards)
+{
+  std::stringstream trace;
+  TraceWriter<std::uint64_t> writer(trace);
+  RecordingMap<aisdi::HashMap<std::uint64_t, int>> map;
+
+  map[1] = 10;
+  map.setTrace(&writer);
+  map[2] = 20;
+  map.setTrace(nullptr);
+  map.remove(1);
+
+  BOOST_CHECK_EQUAL(map.getSize(), 1);
+  BOOST_CHECK_EQUAL(map.valueOf(2), 20);
+  const auto records = readAll<std::uint64_t>(trace);
+  BOOST_REQUIRE_EQUAL(records.size(), 1);
+  BOOST_CHECK_EQUAL(records[0].key, 2);
+  BOOST_CHECK_EQUAL(records[0].valueSize, sizeof(int));
+}
+
+BOOST_AUTO_TEST_CASE(GivenInvalidTraces_WhenReading_ThenExceptionIsThrown)
+{
+  std::stringstream numbers;
+  {
+    TraceWriter<int> writer(numbers);
+    writer.record(TraceOperation::Write, 7, 4, 10);
+  }
+  const std::string recorded = numbers.str();
+
+  std::istringstream otherKey(recorded), garbage("not a trace"), truncated(recorded.substr(0, recorded.size() - 1));
+  BOOST_CHECK_THROW(TraceReader<std::string> reader(otherKey), std::runtime_error);
+  BOOST_CHECK_THROW(TraceReader<int> reader(garbage), std::runtime_error);
+  BOOST_CHECK_THROW(readAll<int>(truncated), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,12 @@
 #include <TreeMap.h>
 
 #include <cstdint>
+#include <functional>
+#include <random>
 #include <string>
 #include <map>
+#include <type_traits>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -543,12 +547,40 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMovingToOther_ThenAllItemsAre
   OperationCountingObject::resetCounters();
   Map<K> other{std::move(map)};
 
-  thenConstructedObjectsCountWas<K>(4);
-  thenCopiedObjectsCountWas<K>(2);
+  thenConstructedObjectsCountWas<K>(0);
+  thenCopiedObjectsCountWas<K>(0);
   thenAssignedObjectsCountWas<K>(0);
   thenMovedObjectsCountWas<K>(0);
-  thenDestroyedObjectsCountWas<K>(2);
+  thenDestroyedObjectsCountWas<K>(0);
   thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMovedFromMap_WhenUsingItAgain_ThenItBehavesLikeEmptyMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" } };
+  Map<K> other{std::move(map)};
+
+  BOOST_CHECK(!map.contains(753));
+  BOOST_CHECK(map.find(753) == map.end());
+  BOOST_CHECK(map.lower_bound(753) == map.end());
+  BOOST_CHECK_THROW(map.remove(753), std::out_of_range);
+  map.merge(std::move(other));
+  map[1789] = "Paris";
+  thenMapContainsItems(map, { { 753, "Rome" }, { 1789, "Paris" } });
+
+  Map<K> moved{std::move(map)};
+  map.union_with(moved);
+  map.emplace_hint(map.cend(), 2000, "Warsaw");
+  thenMapContainsItems(map, { { 753, "Rome" }, { 1789, "Paris" }, { 2000, "Warsaw" } });
+}
+
+BOOST_AUTO_TEST_CASE(GivenTreeMap_WhenCheckingMoveConstructor_ThenItIsNoexcept)
+{
+  BOOST_CHECK((std::is_nothrow_move_constructible<aisdi::TreeMap<int, std::string>>::value));
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenAssigningToOther_ThenOtherMapIsEmpty,
@@ -620,11 +652,13 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenMoveAssigning_ThenAllElements
   OperationCountingObject::resetCounters();
   other = std::move(map);
 
-  thenConstructedObjectsCountWas<K>(2);
-  thenCopiedObjectsCountWas<K>(1);
+  // guards are swapped, only the former items of other are destroyed
+  thenConstructedObjectsCountWas<K>(0);
+  thenCopiedObjectsCountWas<K>(0);
   thenAssignedObjectsCountWas<K>(0);
   thenMovedObjectsCountWas<K>(0);
-  thenDestroyedObjectsCountWas<K>(4);
+  thenDestroyedObjectsCountWas<K>(2);
+  BOOST_CHECK(map.isEmpty());
   thenMapContainsItems(other, { { 753, "Rome" }, { 1789, "Paris" } });
 }
 
@@ -739,6 +773,34 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenSingleItemMap_WhenRemovingItemByIterator_Then
   BOOST_CHECK(map.isEmpty());
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNotEmptyMap_WhenClearing_ThenMapBecomesEmptyAndReusable,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+
+  map.clear();
+
+  BOOST_CHECK(map.isEmpty());
+  BOOST_CHECK(begin(map) == end(map));
+  BOOST_CHECK(map.find(27) == end(map));
+
+  map[27] = "Dave";
+  thenMapContainsItems(map, { { 27, "Dave" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCheckingKeys_ThenOnlyStoredOnesAreContained,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  BOOST_CHECK(map.contains(42));
+  BOOST_CHECK(map.contains(27));
+  BOOST_CHECK(!map.contains(13));
+  BOOST_CHECK(!Map<K>{}.contains(42));
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoEmptyMaps_WhenComparingThem_ThenTheyAreReportedAsEqual,
                               K,
                               TestedKeyTypes)
@@ -789,6 +851,735 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDifferentKeys_WhenComparingThem_Th
   BOOST_CHECK(map != other);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenGettingFrontOrBack_ThenExceptionIsThrown,
+                              K,
+                              TestedKeyTypes)
+{
+  const Map<K> map;
+
+  BOOST_CHECK_THROW(map.front(), std::out_of_range);
+  BOOST_CHECK_THROW(map.back(), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenGettingFrontAndBack_ThenFirstAndLastItemsAreReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+
+  BOOST_CHECK_EQUAL(map.front().first, 13);
+  BOOST_CHECK_EQUAL(map.front().second, "Chuck");
+  BOOST_CHECK_EQUAL(map.back().first, 1410);
+  BOOST_CHECK_EQUAL(map.back().second, "Grunwald");
+  BOOST_CHECK(map.cbegin() == map.find(13));
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenRemovingFirstAndLastItems_ThenFrontAndBackAreUpdated,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" }, { 1410, "Grunwald" } };
+
+  map.remove(13);
+  map.remove(1410);
+
+  BOOST_CHECK_EQUAL(map.front().first, 27);
+  BOOST_CHECK_EQUAL(map.back().first, 42);
+  BOOST_CHECK_EQUAL(map.cbegin()->first, 27);
+  BOOST_CHECK_EQUAL((--map.cend())->first, 42);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMapWithManyItems_WhenRemovingInnerItems_ThenRemainingItemsAreInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 64; ++i)
+  {
+    map[i] = std::to_string(i);
+    expected[i] = std::to_string(i);
+  }
+
+  for (int i = 1; i < 64; i += 3)
+  {
+    map.remove(i);
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  auto expectedIt = expected.begin();
+  for (auto it = map.cbegin(); it != map.cend(); ++it, ++expectedIt)
+    BOOST_CHECK_EQUAL(it->first, expectedIt->first);
+  BOOST_CHECK(expectedIt == expected.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyMap_WhenInsertingIncreasingKeysBeforeEnd_ThenAllItemsAreInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+
+  for (int i = 0; i < 32; ++i)
+  {
+    const auto it = map.insert(map.end(), i, std::to_string(i));
+    BOOST_CHECK_EQUAL(it->first, i);
+  }
+
+  BOOST_CHECK_EQUAL(map.getSize(), 32);
+  int expected = 0;
+  for (auto it = map.cbegin(); it != map.cend(); ++it, ++expected)
+    BOOST_CHECK_EQUAL(it->first, expected);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenInsertingWithHint_ThenItemIsInMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" }, { 40, "d" } };
+
+  map.insert(map.find(30), 25, "e");
+  map.insert(map.find(20), 35, "f");
+  map.insert(map.begin(), 5, "g");
+  map.insert(map.find(40), 45, "h");
+
+  thenMapContainsItems(map, { { 5, "g" }, { 10, "a" }, { 20, "b" }, { 25, "e" },
+                              { 30, "c" }, { 35, "f" }, { 40, "d" }, { 45, "h" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenInsertingExistingKeyWithHint_ThenValueIsNotChanged,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  const auto it = map.insert(map.end(), 27, "Chuck");
+
+  BOOST_CHECK(it == map.find(27));
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenEmplacingWithHint_ThenValueIsConstructedFromArguments,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" } };
+
+  map.emplace_hint(map.end(), 1410, 3, 'x');
+  map.emplace_hint(map.begin(), 27, "Bob");
+
+  thenMapContainsItems(map, { { 27, "Bob" }, { 42, "Alice" }, { 1410, "xxx" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSplitting_ThenGreaterOrEqualKeysAreMovedToResult,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" }, { 40, "d" }, { 50, "e" } };
+
+  const Map<K> other = map.split(30);
+
+  thenMapContainsItems(map, { { 10, "a" }, { 20, "b" } });
+  thenMapContainsItems(other, { { 30, "c" }, { 40, "d" }, { 50, "e" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenEmptyTarget_WhenSplittingIntoIt_ThenNothingIsConstructed,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" } };
+  Map<K> upper, filled = { { 40, "d" } };
+  const K key(20);
+
+  OperationCountingObject::resetCounters();
+  map.split(key, upper);
+
+  thenConstructedObjectsCountWas<K>(0);
+  thenDestroyedObjectsCountWas<K>(0);
+  thenMapContainsItems(map, { { 10, "a" } });
+  thenMapContainsItems(upper, { { 20, "b" }, { 30, "c" } });
+  BOOST_CHECK_THROW(map.split(0, filled), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenErasingRange_ThenOnlyKeysOutsideRangeRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 100; ++i)
+  {
+    map[i] = std::to_string(i);
+    if (i < 25 || i >= 70)
+      expected[i] = std::to_string(i);
+  }
+
+  map.erase_range(25, 70);
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK(map.find(25) == map.end());
+  BOOST_CHECK(map.find(69) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenErasingEmptyRange_ThenNothingIsRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map.erase_range(30, 30);
+  map.erase_range(50, 40);
+  map.erase_range(28, 42);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenExtractingRange_ThenItemsAreMovedToResult,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" }, { 40, "d" }, { 50, "e" } };
+
+  const Map<K> other = map.extract_range(15, 40);
+
+  thenMapContainsItems(map, { { 10, "a" }, { 40, "d" }, { 50, "e" } });
+  thenMapContainsItems(other, { { 20, "b" }, { 30, "c" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithDisjointKeys_WhenMerging_ThenAllItemsAreInFirstMap,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 753, "Rome" }, { 1410, "Grunwald" } };
+  Map<K> other = { { 1789, "Paris" }, { 1815, "Waterloo" } };
+
+  map.merge(std::move(other));
+
+  BOOST_CHECK(other.isEmpty());
+  thenMapContainsItems(map, { { 753, "Rome" }, { 1410, "Grunwald" },
+                              { 1789, "Paris" }, { 1815, "Waterloo" } });
+  BOOST_CHECK_EQUAL(map.front().first, 753);
+  BOOST_CHECK_EQUAL(map.back().first, 1815);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithOverlappingKeys_WhenMerging_ThenExistingValuesAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  Map<K> other = { { 42, "Chuck" }, { 13, "Dave" } };
+
+  map.merge(std::move(other));
+
+  BOOST_CHECK(other.isEmpty());
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" }, { 13, "Dave" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMapsWithInterleavedKeys_WhenMerging_ThenNoItemIsCopied,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  Map<K> other;
+  for (int i = 0; i < 1000; ++i)
+  {
+    map[2 * i] = "even";
+    other[3 * i] = "triple";
+  }
+  OperationCountingObject::resetCounters();
+
+  map.merge(std::move(other));
+
+  thenConstructedObjectsCountWas<K>(0);
+  thenCopiedObjectsCountWas<K>(0);
+  thenDestroyedObjectsCountWas<K>(334); // keys divisible by 6 were already present
+  BOOST_CHECK(other.isEmpty());
+  BOOST_CHECK_EQUAL(map.getSize(), 1666u);
+  BOOST_CHECK_EQUAL(map.valueOf(6), "even");
+  BOOST_CHECK_EQUAL(map.valueOf(2997), "triple");
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenUniting_ThenFirstMapContainsAllKeysWithItsValuesPreferred,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+  const Map<K> other = { { 42, "Chuck" }, { 13, "Dave" } };
+
+  map.union_with(other);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" }, { 13, "Dave" } });
+  thenMapContainsItems(other, { { 42, "Chuck" }, { 13, "Dave" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenIntersecting_ThenOnlyCommonKeysRemain,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+  const Map<K> other = { { 42, "Dave" }, { 13, "Eve" }, { 7, "Frank" } };
+
+  map.intersect_with(other);
+
+  thenMapContainsItems(map, { { 42, "Alice" }, { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoMaps_WhenSubtracting_ThenKeysOfOtherMapAreRemoved,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" }, { 13, "Chuck" } };
+  const Map<K> other = { { 42, "Dave" }, { 7, "Frank" } };
+
+  map.difference(other);
+
+  thenMapContainsItems(map, { { 27, "Bob" }, { 13, "Chuck" } });
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenMap_WhenCombiningWithItself_ThenResultIsConsistent,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 42, "Alice" }, { 27, "Bob" } };
+
+  map.union_with(map);
+  map.intersect_with(map);
+  thenMapContainsItems(map, { { 42, "Alice" }, { 27, "Bob" } });
+
+  map.difference(map);
+  BOOST_CHECK(map.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenTwoLargeMaps_WhenCombiningThem_ThenResultsMatchSetOperations,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> evens, triples;
+  std::map<K, std::string> united, common, rest;
+  for (int i = 0; i < 30000; ++i)
+  {
+    if (i % 2 == 0)
+      evens[i] = "even";
+    if (i % 3 == 0)
+      triples[i] = "triple";
+
+    if (i % 2 == 0)
+      united[i] = "even";
+    else if (i % 3 == 0)
+      united[i] = "triple";
+    if (i % 6 == 0)
+      common[i] = "even";
+    if (i % 2 == 0 && i % 3 != 0)
+      rest[i] = "even";
+  }
+
+  Map<K> unionResult{evens}, intersectionResult{evens}, differenceResult{evens};
+  unionResult.union_with(triples);
+  intersectionResult.intersect_with(triples);
+  differenceResult.difference(triples);
+
+  thenMapContainsItems(unionResult, united);
+  thenMapContainsItems(intersectionResult, common);
+  thenMapContainsItems(differenceResult, rest);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenNonEmptyMap_WhenSearchingLowerBound_ThenFirstNotLessItemIsReturned,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map = { { 10, "a" }, { 20, "b" }, { 30, "c" } };
+  const Map<K> empty;
+
+  BOOST_CHECK_EQUAL(map.lower_bound(5)->first, 10);
+  BOOST_CHECK_EQUAL(map.lower_bound(20)->first, 20);
+  BOOST_CHECK_EQUAL(map.lower_bound(21)->first, 30);
+  BOOST_CHECK(map.lower_bound(31) == map.end());
+  BOOST_CHECK(empty.lower_bound(1) == empty.end());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMap_WhenDestroyed_ThenEveryItemIsReleased,
+                              K,
+                              TestedKeyTypes)
+{
+  {
+    Map<K> map;
+    for (int i = 0; i < 100000; ++i)
+      map[i] = "x";
+
+    OperationCountingObject::resetCounters();
+  }
+
+  thenDestroyedObjectsCountWas<K>(100001); // items and the guard
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenLargeMap_WhenRemovingEveryOtherKey_ThenRemainingItemsAreKept,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 20000; ++i)
+    map[i] = expected[i] = std::to_string(i);
+
+  for (int i = 0; i < 20000; i += 2)
+  {
+    map.remove(i);
+    expected.erase(i);
+  }
+
+  thenMapContainsItems(map, expected);
+  BOOST_CHECK_EQUAL(map.front().first, 1);
+  BOOST_CHECK_EQUAL(map.back().first, 19999);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenRestructuredMap_WhenIteratingBothWays_ThenItemsAreInOrder,
+                              K,
+                              TestedKeyTypes)
+{
+  Map<K> map, odds;
+  std::map<K, std::string> expected;
+  for (int i = 0; i < 3000; ++i)
+  {
+    map[2 * i] = expected[2 * i] = "even";
+    odds[2 * i + 1] = "odd";
+  }
+
+  map.insert(map.find(100), 99, "hint");
+  expected[99] = "hint";
+  map.remove(map.find(0));
+  expected.erase(0);
+  map.erase_range(1000, 2000);
+  expected.erase(expected.lower_bound(1000), expected.lower_bound(2000));
+  Map<K> high = map.split(4000);
+  map.merge(std::move(high));
+  map.union_with(odds.extract_range(5001, 5101));
+  for (int i = 5001; i < 5101; i += 2)
+    expected[i] = "odd";
+
+  thenMapContainsItems(map, expected);
+
+  auto it = map.cend();
+  for (auto item = expected.rbegin(); item != expected.rend(); ++item)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, item->first);
+  }
+  BOOST_CHECK(it == map.cbegin());
+  BOOST_CHECK_THROW(--it, std::out_of_range);
+}
+
+namespace
+{
+
+struct CountingLess
+{
+  static std::size_t comparisons;
+
+  bool operator()(int a, int b) const
+  {
+    ++comparisons;
+    return a < b;
+  }
+};
+
+std::size_t CountingLess::comparisons = 0;
+
+// lookups check that the whole tree is heap ordered by priorities handed out in created()
+struct HeapCheckingTreapBalance : aisdi::TreapBalance
+{
+  static bool heapOrdered;
+
+  template <typename Node>
+  static Node* accessed(Node* node)
+  {
+    while (!isRoot(node))
+      node = node->parent;
+    heapOrdered = isHeap(node);
+    return nullptr;
+  }
+
+  // 1 is the priority of a node created() never saw
+  template <typename Node>
+  static bool isHeap(Node* node)
+  {
+    if (node == nullptr)
+      return true;
+    if (priority(node) == 1 || priority(node->left) > priority(node) || priority(node->right) > priority(node))
+      return false;
+    return isHeap(node->left) && isHeap(node->right);
+  }
+};
+
+bool HeapCheckingTreapBalance::heapOrdered = false;
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(GivenDescendingComparator_WhenIterating_ThenItemsGoFromLargestKey)
+{
+  aisdi::TreeMap<int, std::string, std::greater<int>> map = { { 1, "a" }, { 3, "c" }, { 2, "b" } };
+
+  std::vector<int> keys;
+  for (auto&& item : map)
+    keys.push_back(item.first);
+
+  BOOST_CHECK(keys == std::vector<int>({ 3, 2, 1 }));
+  BOOST_CHECK_EQUAL(map.lower_bound(2)->first, 2);
+  BOOST_CHECK_EQUAL(map.split(2).getSize(), 2);
+  BOOST_CHECK_EQUAL(map.front().first, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTransparentComparator_WhenLookingUpWithCString_ThenItemIsFound)
+{
+  aisdi::TreeMap<std::string, int, std::less<>> map = { { "abc", 1 }, { "abd", 2 } };
+
+  BOOST_CHECK_EQUAL(map.find("abd")->second, 2);
+  BOOST_CHECK(map.find("abe") == map.end());
+  BOOST_CHECK_EQUAL(map.valueOf("abc"), 1);
+  BOOST_CHECK_EQUAL(map.lower_bound("abcc")->first, "abd");
+}
+
+BOOST_AUTO_TEST_CASE(GivenMap_WhenFindingKeys_ThenOneComparisonPerLevelIsMade)
+{
+  aisdi::TreeMap<int, int, CountingLess> map;
+  for (int i = 0; i < 1023; ++i)
+    map[i * 2] = i;
+
+  for (int i = 0; i < 2046; ++i)
+  {
+    CountingLess::comparisons = 0;
+    map.find(i);
+    // perfectly balanced tree of height 10, plus a single equality check
+    BOOST_CHECK_LE(CountingLess::comparisons, 11u);
+  }
+}
+
+using TestedBalancePolicies = boost::mpl::list<aisdi::AvlBalance, aisdi::RedBlackBalance,
+                                               aisdi::TreapBalance, aisdi::SplayBalance>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBalancePolicy_WhenAddingAndRemovingRandomKeys_ThenMapMatchesStdMap,
+                              Balance,
+                              TestedBalancePolicies)
+{
+  aisdi::TreeMap<int, int, std::less<int>, Balance> map;
+  std::map<int, int> expected;
+  std::mt19937 generator(17);
+
+  for (int i = 0; i < 30000; ++i)
+  {
+    const int key = generator() % 3000;
+    if (generator() % 3 == 0)
+    {
+      if (expected.erase(key) == 1)
+        map.remove(key);
+      else
+        BOOST_CHECK_THROW(map.remove(key), std::out_of_range);
+    }
+    else
+    {
+      map[key] = i;
+      expected[key] = i;
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(map.valueOf(item.first), item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == map.cend());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBalancePolicy_WhenUsingRangeAndSetOperations_ThenResultsMatchStdMap,
+                              Balance,
+                              TestedBalancePolicies)
+{
+  using PolicyMap = aisdi::TreeMap<int, int, std::less<int>, Balance>;
+  PolicyMap map, triples;
+  std::map<int, int> expected;
+  // increasing keys leave a splay tree as a single path
+  for (int i = 0; i < 100000; ++i)
+  {
+    map[i] = expected[i] = i;
+    if (i % 3 == 0)
+      triples[i] = -i;
+  }
+
+  map.erase_range(1000, 2000);
+  expected.erase(expected.lower_bound(1000), expected.lower_bound(2000));
+  PolicyMap high = map.split(50000);
+  map.difference(triples);
+  for (int i = 0; i < 50000; i += 3)
+    expected.erase(i);
+  map.merge(std::move(high));
+
+  BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+  auto it = map.cend();
+  for (auto item = expected.rbegin(); item != expected.rend(); ++item)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, item->first);
+  }
+  BOOST_CHECK(it == map.cbegin());
+
+  if (!std::is_same<Balance, aisdi::SplayBalance>::value)
+    return;
+  // a path this long still overflows the stack when walked recursively after the cut point is splayed
+  const int pathLength = 2000000;
+  PolicyMap splitPath, erasedPath;
+  for (int i = 0; i < pathLength; ++i)
+    splitPath[i] = erasedPath[i] = i;
+
+  PolicyMap rest = splitPath.split(1);
+  BOOST_CHECK_EQUAL(splitPath.getSize(), 1u);
+  BOOST_CHECK_EQUAL(rest.getSize(), static_cast<std::size_t>(pathLength - 1));
+  BOOST_CHECK_EQUAL(rest.cbegin()->first, 1);
+  erasedPath.erase_range(1, pathLength);
+  BOOST_CHECK_EQUAL(erasedPath.getSize(), 1u);
+  BOOST_CHECK_EQUAL(erasedPath.cbegin()->first, 0);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenBalancePolicy_WhenUnitingAndIntersecting_ThenIterationWorksBothWays,
+                              Balance,
+                              TestedBalancePolicies)
+{
+  using PolicyMap = aisdi::TreeMap<int, int, std::less<int>, Balance>;
+  PolicyMap map, fives, odds;
+  std::map<int, int> expected;
+  for (int i = 0; i < 20000; ++i)
+  {
+    if (i % 2 == 0)
+      map[i] = expected[i] = i;
+    if (i % 5 == 0)
+      fives[i] = -i;
+    if (i % 2 == 1 && i > 10000)
+      odds[i] = -i;
+  }
+
+  map.union_with(fives);
+  for (int i = 0; i < 20000; i += 5)
+    expected.insert({ i, -i });
+  map.intersect_with(fives);
+  for (auto item = expected.begin(); item != expected.end();)
+    item = item->first % 5 == 0 ? std::next(item) : expected.erase(item);
+  map.merge(std::move(odds));
+  for (int i = 10001; i < 20000; i += 2)
+    expected.insert({ i, -i });
+
+  BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == map.cend());
+  for (auto item = expected.rbegin(); item != expected.rend(); ++item)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, item->first);
+  }
+  BOOST_CHECK(it == map.cbegin());
+}
+
+template <typename Map>
+void thenMapMatchesBothWays(const Map& map, const std::map<int, int>& expected)
+{
+  BOOST_REQUIRE_EQUAL(map.getSize(), expected.size());
+  auto it = map.cbegin();
+  for (const auto& item : expected)
+  {
+    BOOST_CHECK_EQUAL(it->first, item.first);
+    BOOST_CHECK_EQUAL(it->second, item.second);
+    ++it;
+  }
+  BOOST_CHECK(it == map.cend());
+  for (auto item = expected.rbegin(); item != expected.rend(); ++item)
+  {
+    --it;
+    BOOST_CHECK_EQUAL(it->first, item->first);
+  }
+  BOOST_CHECK(it == map.cbegin());
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(GivenUnthreadedMap_WhenMixingOperations_ThenResultsMatchStdMap,
+                              Balance,
+                              TestedBalancePolicies)
+{
+  using UnthreadedMap = aisdi::TreeMap<int, int, std::less<int>, Balance, aisdi::ParentLinks>;
+  UnthreadedMap map, evens;
+  std::map<int, int> expected;
+  std::mt19937 generator(29);
+  for (int i = 0; i < 20000; ++i)
+  {
+    const int key = generator() % 4000;
+    if (generator() % 3 == 0)
+    {
+      if (expected.erase(key) == 1)
+        map.remove(key);
+    }
+    else
+      map[key] = expected[key] = i;
+  }
+  for (int i = 4000; i < 5000; ++i)
+  {
+    map.emplace_hint(map.cend(), i, i);
+    expected[i] = i;
+  }
+  thenMapMatchesBothWays(map, expected);
+
+  for (int i = 0; i < 6000; i += 2)
+    evens[i] = -i;
+  map.union_with(evens);
+  for (int i = 0; i < 6000; i += 2)
+    expected.insert({ i, -i });
+  thenMapMatchesBothWays(map, expected);
+
+  map.erase_range(1000, 1500);
+  expected.erase(expected.lower_bound(1000), expected.lower_bound(1500));
+  UnthreadedMap high = map.split(3000);
+  map.intersect_with(evens);
+  for (auto item = expected.begin(); item != expected.end() && item->first < 3000;)
+    item = item->first % 2 == 0 ? std::next(item) : expected.erase(item);
+  high.difference(evens);
+  for (auto item = expected.lower_bound(3000); item != expected.end();)
+    item = item->first % 2 == 0 ? expected.erase(item) : std::next(item);
+  map.merge(std::move(high));
+  thenMapMatchesBothWays(map, expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSplayPolicy_WhenLookingUpKey_ThenItBecomesTheRoot)
+{
+  aisdi::TreeMap<int, int, CountingLess, aisdi::SplayBalance> counted;
+  for (int i = 0; i < 1000; ++i)
+    counted[(i * 389) % 1000] = i;
+
+  counted.find(123);
+  CountingLess::comparisons = 0;
+  counted.find(123);
+  // root match: one comparison down the tree, one equality check
+  BOOST_CHECK_LE(CountingLess::comparisons, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoTreapMaps_WhenUnitingThem_ThenTreeIsHeapOrdered)
+{
+  aisdi::TreeMap<int, int, std::less<int>, HeapCheckingTreapBalance> map, other;
+  for (int i = 0; i < 1000; ++i)
+  {
+    map[2 * i] = i;
+    other[2 * i + 1] = i;
+  }
+
+  map.union_with(other);
+
+  BOOST_REQUIRE_EQUAL(map.getSize(), 2000u);
+  map.find(0);
+  BOOST_CHECK(HeapCheckingTreapBalance::heapOrdered);
+}
+
 // ConstIterator is tested via Iterator methods.
 // If Iterator methods are to be changed, then new ConstIterator tests are required.
 
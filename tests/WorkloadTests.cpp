@@ -0,0 +1,144 @@
+#include <Workload.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using aisdi::KeyDistribution;
+using aisdi::WorkloadGenerator;
+using aisdi::WorkloadOperationType;
+using aisdi::WorkloadSpec;
+
+BOOST_AUTO_TEST_SUITE(WorkloadTests)
+
+std::vector<std::uint64_t> recordHits(const WorkloadSpec& spec, std::uint64_t recordCount, int draws)
+{
+  WorkloadGenerator generator(spec, recordCount, 7);
+  std::vector<std::uint64_t> hits(recordCount);
+  for (int i = 0; i < draws; ++i)
+    ++hits[generator.next().record];
+  return hits;
+}
+
+BOOST_AUTO_TEST_CASE(GivenSameSeed_WhenGeneratingOperations_ThenStreamsAreEqual)
+{
+  WorkloadGenerator first(WorkloadSpec::ycsbA(), 1000, 42);
+  WorkloadGenerator second(WorkloadSpec::ycsbA(), 1000, 42);
+  WorkloadGenerator other(WorkloadSpec::ycsbA(), 1000, 43);
+
+  bool differs = false;
+  for (int i = 0; i < 1000; ++i)
+  {
+    const auto a = first.next(), b = second.next(), c = other.next();
+    BOOST_CHECK(a.type == b.type);
+    BOOST_CHECK_EQUAL(a.record, b.record);
+    differs = differs || a.record != c.record;
+  }
+  BOOST_CHECK(differs);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWorkloadMix_WhenGeneratingOperations_ThenProportionsAreKept)
+{
+  WorkloadGenerator generator(WorkloadSpec::ycsbB(), 1000, 1);
+  int reads = 0, updates = 0;
+  for (int i = 0; i < 100000; ++i)
+  {
+    const auto operation = generator.next();
+    BOOST_REQUIRE(operation.type == WorkloadOperationType::Read || operation.type == WorkloadOperationType::Update);
+    BOOST_REQUIRE_LT(operation.record, 1000);
+    (operation.type == WorkloadOperationType::Read ? reads : updates) += 1;
+  }
+
+  BOOST_CHECK_CLOSE(reads / 100000.0, 0.95, 1);
+  BOOST_CHECK_CLOSE(updates / 100000.0, 0.05, 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInsertsAndScans_WhenGeneratingOperations_ThenNewRecordsAreAppendedAndScansBounded)
+{
+  WorkloadGenerator generator(WorkloadSpec::ycsbE(), 100, 3);
+  std::uint64_t expected = 100;
+  for (int i = 0; i < 10000; ++i)
+  {
+    const auto operation = generator.next();
+    if (operation.type == WorkloadOperationType::Insert)
+      BOOST_REQUIRE_EQUAL(operation.record, expected++);
+    else
+    {
+      BOOST_REQUIRE(operation.type == WorkloadOperationType::Scan);
+      BOOST_REQUIRE_LT(operation.record, expected);
+      BOOST_REQUIRE(operation.scanLength >= 1 && operation.scanLength <= 100);
+    }
+  }
+  BOOST_CHECK_EQUAL(generator.getRecordCount(), expected);
+  BOOST_CHECK_GT(expected, 100);
+}
+
+BOOST_AUTO_TEST_CASE(GivenZipfianGenerator_WhenDrawingRanks_ThenFrequenciesFollowPowerLaw)
+{
+  aisdi::ZipfianGenerator zipfian(1000, 0.99);
+  std::mt19937_64 random(5);
+  std::vector<int> hits(1000);
+  for (int i = 0; i < 200000; ++i)
+    ++hits[zipfian(random, 1000)];
+
+  // P(0) / P(9) = 10^0.99
+  BOOST_CHECK_CLOSE(static_cast<double>(hits[0]) / hits[9], std::pow(10, 0.99), 15);
+  BOOST_CHECK_GT(hits[1], hits[100]);
+  BOOST_CHECK_THROW(aisdi::ZipfianGenerator(10, 1), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenScrambledZipfian_WhenChoosingRecords_ThenHotRecordsAreNotNeighbours)
+{
+  const auto hits = recordHits(WorkloadSpec::ycsbC(), 1000, 100000);
+
+  const auto hottest = std::max_element(hits.begin(), hits.end()) - hits.begin();
+  BOOST_CHECK_GT(hits[hottest], 100000 / 20);
+  BOOST_CHECK_NE(hottest, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLatestDistribution_WhenChoosingRecords_ThenRecentRecordsArePreferred)
+{
+  WorkloadSpec spec = WorkloadSpec::ycsbC();
+  spec.distribution = KeyDistribution::Latest;
+  const auto hits = recordHits(spec, 1000, 100000);
+
+  BOOST_CHECK_GT(hits[999], hits[990]);
+  BOOST_CHECK_GT(hits[990], hits[0]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenHotspotDistribution_WhenChoosingRecords_ThenHotSetGetsItsShare)
+{
+  WorkloadSpec spec = WorkloadSpec::ycsbC();
+  spec.distribution = KeyDistribution::Hotspot;
+  const auto hits = recordHits(spec, 1000, 100000);
+
+  int hot = 0;
+  for (int i = 0; i < 200; ++i)
+    hot += hits[i];
+  BOOST_CHECK_CLOSE(hot / 100000.0, 0.8, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWorkloadKeys_WhenMakingThem_ThenDistinctRecordsGiveDistinctKeys)
+{
+  std::set<std::uint64_t> numbers;
+  std::set<std::string> strings;
+  std::set<std::size_t> lengths;
+  for (std::uint64_t record = 0; record < 10000; ++record)
+  {
+    BOOST_CHECK_EQUAL(aisdi::WorkloadKey<int>::make(record), static_cast<int>(record));
+    numbers.insert(aisdi::WorkloadKey<std::uint64_t>::make(record));
+    strings.insert(aisdi::WorkloadKey<std::string>::make(record));
+    lengths.insert(aisdi::WorkloadKey<std::string>::make(record).size());
+  }
+
+  BOOST_CHECK_EQUAL(numbers.size(), 10000);
+  BOOST_CHECK_EQUAL(strings.size(), 10000);
+  BOOST_CHECK_GT(lengths.size(), 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()